@@ -0,0 +1,500 @@
+
+// PeykNowruzi - Basic ASCII-Art Generator
+// Copyright (C) 2021-2022 Kasra Hashemi
+
+/*
+
+ This file is part of PeykNowruzi.
+
+ PeykNowruzi is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License,
+ or (at your option) any later version.
+
+ PeykNowruzi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty
+ of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with PeykNowruzi. If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+
+// Times the hot paths of PeykNowruzi in isolation and writes the results as
+// JSON to the standard output, with a short summary on the standard error.
+// Each benchmark first finds how many iterations make a sample last at least
+// the minimum sample time, then runs the warmup samples and the measured ones.
+
+
+#include "CharMatrix.hpp"
+#include "CanvasFile.hpp"
+#include "Util.hpp"
+#include "pch.hpp"
+
+
+namespace peyknowruzi::bench
+{
+
+struct BenchmarkSettings
+{
+	std::size_t warmupSamplesCount { 5 };
+	std::size_t samplesCount { 50 };
+	std::chrono::nanoseconds minSampleTime { std::chrono::milliseconds { 1 } };
+	std::string_view filter { }; // only benchmarks whose name contains it are run
+};
+
+struct BenchmarkResult
+{
+	std::string_view name;
+	std::size_t iterationsPerSample;
+	std::vector<double> nsPerIteration; // one entry per sample, sorted
+};
+
+using coords_type = std::array<std::uint32_t, CharMatrix<>::cartesian_components_count>;
+
+// keeps the compiler from dropping a computation whose result is never used
+template < class T >
+inline void do_not_optimize( const T& value ) noexcept
+{
+#if defined( __GNUC__ )
+	asm volatile( "" : : "g"( &value ) : "memory" );
+#else
+	static_cast<void>( *static_cast<const volatile char*>( static_cast<const volatile void*>( &value ) ) );
+#endif
+}
+
+template < class Body >
+[[ nodiscard ]] std::chrono::nanoseconds time_iterations( Body& body, const std::size_t iterationsCount )
+{
+	return util::FunctionTimer< std::chrono::nanoseconds >::duration( [ & ]( )
+	{
+		for ( std::size_t iteration { }; iteration < iterationsCount; ++iteration ) { body( ); }
+	} );
+}
+
+template < class Body >
+void run_benchmark( const std::string_view name, const BenchmarkSettings& settings,
+					std::vector<BenchmarkResult>& results_OUT, Body&& body )
+{
+	static constexpr std::size_t max_iterations_per_sample { std::size_t { 1 } << 30 };
+
+	if ( name.find( settings.filter ) == std::string_view::npos ) { return; }
+
+	std::size_t iterationsPerSample { 1 };
+
+	while ( time_iterations( body, iterationsPerSample ) < settings.minSampleTime &&
+			iterationsPerSample < max_iterations_per_sample )
+	{
+		iterationsPerSample *= 2;
+	}
+
+	for ( std::size_t sample { }; sample < settings.warmupSamplesCount; ++sample )
+	{
+		static_cast<void>( time_iterations( body, iterationsPerSample ) );
+	}
+
+	BenchmarkResult result { name, iterationsPerSample, { } };
+	result.nsPerIteration.reserve( settings.samplesCount );
+
+	for ( std::size_t sample { }; sample < settings.samplesCount; ++sample )
+	{
+		result.nsPerIteration.push_back( static_cast<double>( time_iterations( body, iterationsPerSample ).count( ) ) /
+										 static_cast<double>( iterationsPerSample ) );
+	}
+
+	std::ranges::sort( result.nsPerIteration );
+	results_OUT.push_back( std::move( result ) );
+}
+
+// nearest rank percentile of sorted, which must not be empty
+[[ nodiscard ]] double percentile( const std::span<const double> sorted, const double percent ) noexcept
+{
+	const double rank { std::ceil( percent / 100.0 * static_cast<double>( sorted.size( ) ) ) };
+
+	return sorted[ std::clamp<std::size_t>( static_cast<std::size_t>( rank ), 1, sorted.size( ) ) - 1 ];
+}
+
+// a reproducible figure of count characters that all lie inside a Y_AxisLen by
+// X_AxisLen canvas
+[[ nodiscard ]] std::vector<coords_type>
+make_figure( const std::uint32_t Y_AxisLen, const std::uint32_t X_AxisLen, const std::size_t count )
+{
+	std::vector<coords_type> coordsOfChars;
+	coordsOfChars.reserve( count );
+
+	std::uint64_t state { 0x9E3779B97F4A7C15 };
+
+	const auto next_random { [ &state ]( const std::uint32_t bound )
+	{
+		state = state * 6364136223846793005 + 1442695040888963407;
+		return static_cast<std::uint32_t>( ( state >> 33 ) % bound );
+	} };
+
+	for ( std::size_t idx { }; idx < count; ++idx )
+	{
+		const std::uint32_t x1 { next_random( X_AxisLen - 2 ) };
+		const std::uint32_t y1 { next_random( Y_AxisLen - 1 ) };
+
+		switch ( next_random( 4 ) )
+		{
+			case 0: coordsOfChars.push_back( { x1, y1, x1 + 1, y1 } ); break; // '-'
+			case 1: coordsOfChars.push_back( { x1, y1, x1 + 1, y1 + 1 } ); break; // '\'
+			case 2: coordsOfChars.push_back( { x1, y1, x1, y1 + 1 } ); break; // '|'
+			default: coordsOfChars.push_back( { x1, y1 + 1, x1 + 1, y1 } ); break; // '/'
+		}
+	}
+
+	return coordsOfChars;
+}
+
+void write_json_string( std::ostream& output_stream, const std::string_view str )
+{
+	static constexpr std::string_view hex_digits { "0123456789abcdef" };
+
+	output_stream << '"';
+
+	for ( const char ch : str )
+	{
+		if ( ch == '"' || ch == '\\' ) { output_stream << '\\' << ch; }
+		else if ( static_cast<unsigned char>( ch ) < 0x20 )
+		{
+			output_stream << "\\u00" << hex_digits[ static_cast<unsigned char>( ch ) >> 4 ]
+						  << hex_digits[ static_cast<unsigned char>( ch ) & 0xF ];
+		}
+		else { output_stream << ch; }
+	}
+
+	output_stream << '"';
+}
+
+void write_json_report( std::ostream& output_stream, const BenchmarkSettings& settings,
+						const std::span<const BenchmarkResult> results )
+{
+#if defined( __AVX2__ )
+	static constexpr std::string_view simd_level { "avx2" };
+#elif defined( __SSSE3__ )
+	static constexpr std::string_view simd_level { "ssse3" };
+#elif defined( __SSE2__ )
+	static constexpr std::string_view simd_level { "sse2" };
+#else
+	static constexpr std::string_view simd_level { "scalar" };
+#endif
+
+#if defined( __VERSION__ )
+	static constexpr std::string_view compiler_version { __VERSION__ };
+#else
+	static constexpr std::string_view compiler_version { "unknown" };
+#endif
+
+	const std::ios_base::fmtflags flags { output_stream.flags( ) };
+	const std::streamsize precision { output_stream.precision( 3 ) };
+	output_stream << std::fixed;
+
+	output_stream << "{\n  \"context\": {\n    \"compiler\": ";
+	write_json_string( output_stream, compiler_version );
+	output_stream << ",\n    \"simd\": ";
+	write_json_string( output_stream, simd_level );
+	output_stream << ",\n    \"hardware_threads\": " << std::thread::hardware_concurrency( )
+				  << ",\n    \"warmup_samples\": " << settings.warmupSamplesCount
+				  << ",\n    \"samples\": " << settings.samplesCount
+				  << ",\n    \"min_sample_time_ns\": " << settings.minSampleTime.count( )
+				  << "\n  },\n  \"benchmarks\": [";
+
+	for ( std::size_t idx { }; idx < results.size( ); ++idx )
+	{
+		const BenchmarkResult& result { results[ idx ] };
+		const std::span<const double> sorted { result.nsPerIteration };
+
+		const double mean { std::accumulate( sorted.begin( ), sorted.end( ), 0.0 ) /
+							static_cast<double>( sorted.size( ) ) };
+		const double variance { std::accumulate( sorted.begin( ), sorted.end( ), 0.0,
+												 [ mean ]( const double sum, const double ns )
+												 { return sum + ( ns - mean ) * ( ns - mean ); } ) /
+								static_cast<double>( sorted.size( ) ) };
+
+		output_stream << ( idx == 0 ? "\n" : ",\n" ) << "    {\n      \"name\": ";
+		write_json_string( output_stream, result.name );
+		output_stream << ",\n      \"iterations_per_sample\": " << result.iterationsPerSample
+					  << ",\n      \"ns_per_iteration\": {"
+					  << " \"min\": " << sorted.front( )
+					  << ", \"mean\": " << mean
+					  << ", \"stddev\": " << std::sqrt( variance )
+					  << ", \"p50\": " << percentile( sorted, 50 )
+					  << ", \"p90\": " << percentile( sorted, 90 )
+					  << ", \"p99\": " << percentile( sorted, 99 )
+					  << ", \"max\": " << sorted.back( ) << " }\n    }";
+	}
+
+	output_stream << "\n  ]\n}\n";
+
+	output_stream.flags( flags );
+	output_stream.precision( precision );
+}
+
+void write_summary( std::ostream& output_stream, const std::span<const BenchmarkResult> results )
+{
+	const std::ios_base::fmtflags flags { output_stream.flags( ) };
+	const std::streamsize precision { output_stream.precision( 1 ) };
+	output_stream << std::fixed;
+
+	for ( const BenchmarkResult& result : results )
+	{
+		output_stream << result.name << ": " << percentile( result.nsPerIteration, 50 ) << " ns median, "
+					  << percentile( result.nsPerIteration, 99 ) << " ns p99\n";
+	}
+
+	output_stream.flags( flags );
+	output_stream.precision( precision );
+}
+
+[[ nodiscard ]] BenchmarkSettings parse_settings( const std::span<char* const> args )
+{
+	using std::string_view_literals::operator""sv;
+
+	static constexpr std::string_view samples_option_prefix { "--samples="sv };
+	static constexpr std::string_view warmup_option_prefix { "--warmup="sv };
+	static constexpr std::string_view min_sample_time_option_prefix { "--min-sample-time-us="sv };
+	static constexpr std::string_view filter_option_prefix { "--filter="sv };
+
+	BenchmarkSettings settings { };
+
+	for ( const std::string_view arg : args.subspan( std::min<std::size_t>( args.size( ), 1 ) ) )
+	{
+		if ( arg.starts_with( samples_option_prefix ) )
+		{
+			settings.samplesCount = util::parse_option_value<std::size_t>( arg, samples_option_prefix, 1 );
+		}
+		else if ( arg.starts_with( warmup_option_prefix ) )
+		{
+			settings.warmupSamplesCount = util::parse_option_value<std::size_t>( arg, warmup_option_prefix );
+		}
+		else if ( arg.starts_with( min_sample_time_option_prefix ) )
+		{
+			settings.minSampleTime = std::chrono::microseconds {
+				util::parse_option_value<std::int64_t>( arg, min_sample_time_option_prefix, 1 ) };
+		}
+		else if ( arg.starts_with( filter_option_prefix ) )
+		{
+			settings.filter = arg.substr( filter_option_prefix.size( ) );
+		}
+		else
+		{
+			throw std::runtime_error( "Invalid_Option_Exception: Unknown option '" + std::string { arg } + "'" );
+		}
+	}
+
+	return settings;
+}
+
+[[ nodiscard ]] std::vector<BenchmarkResult> run_benchmarks( const BenchmarkSettings& settings )
+{
+	static constexpr std::uint32_t Y_AxisLen { 36 };
+	static constexpr std::uint32_t X_AxisLen { 168 };
+	static constexpr std::uint32_t max_dense_y_axis_len { CharMatrix<>::max_allowed_y_axis_len };
+	static constexpr std::uint32_t max_dense_x_axis_len { CharMatrix<>::max_allowed_x_axis_len };
+	static constexpr std::uint32_t large_axis_len { 1024 };
+	static constexpr std::string_view coords_line { "  80 \t20 81   21" };
+
+	std::vector<BenchmarkResult> results;
+
+	const std::vector<coords_type> figure { make_figure( Y_AxisLen, X_AxisLen, 1024 ) };
+	const std::vector<coords_type> max_dense_figure { make_figure( max_dense_y_axis_len, max_dense_x_axis_len, 2048 ) };
+	const std::vector<coords_type> large_figure { make_figure( large_axis_len, large_axis_len, 64 * 1024 ) };
+
+	util::DiscardingStreambuf discarding_buffer;
+	std::ostream discarding_stream { &discarding_buffer };
+
+	run_benchmark( "tokenize", settings, results, [ & ]( )
+	{
+		const std::vector<std::string_view> tokens { util::tokenize( coords_line, 4 ) };
+		do_not_optimize( tokens );
+	} );
+
+	run_benchmark( "tokenize_fast", settings, results, [ & ]( )
+	{
+		std::array<std::string_view, 4> tokens;
+		const std::size_t foundTokensCount { util::tokenize_fast( coords_line, tokens, 4 ) };
+		do_not_optimize( foundTokensCount );
+		do_not_optimize( tokens );
+	} );
+
+	run_benchmark( "to_integer", settings, results, [ & ]( )
+	{
+		using std::string_view_literals::operator""sv;
+
+		const std::optional<std::uint32_t> integer { util::to_integer<std::uint32_t>( "1234567"sv,
+													 { 0, std::numeric_limits<std::uint32_t>::max( ) } ) };
+		do_not_optimize( integer );
+	} );
+
+	{
+		static constexpr std::array<std::string_view, 4> tokens { "80", "20", "81", "21" };
+		static constexpr std::array<std::size_t, 4> tokens_indices { 0, 1, 2, 3 };
+
+		run_benchmark( "convert_specific_tokens_to_integers", settings, results, [ & ]( )
+		{
+			std::array<std::uint32_t, 4> integers;
+			const bool isValid { util::convert_specific_tokens_to_integers<std::uint32_t>( tokens, integers,
+																						   tokens_indices ) };
+			do_not_optimize( isValid );
+			do_not_optimize( integers );
+		} );
+	}
+
+	{
+		const CharMatrix<> matrix { Y_AxisLen, X_AxisLen, ' ' };
+
+		run_benchmark( "validateEnteredCoords", settings, results, [ & ]( )
+		{
+			coords_type coords;
+			const bool isValid { matrix.validateEnteredCoords( coords_line, coords ) };
+			do_not_optimize( isValid );
+			do_not_optimize( coords );
+		} );
+	}
+
+	{
+		CharMatrix<> matrix { Y_AxisLen, X_AxisLen, ' ' };
+		std::size_t idx { };
+
+		run_benchmark( "setCharacterMatrix/single", settings, results, [ & ]( )
+		{
+			matrix.setCharacterMatrix( figure[ idx ] );
+			idx = ( idx + 1 ) % figure.size( );
+			do_not_optimize( matrix );
+		} );
+
+		run_benchmark( "setCharacterMatrix/figure_1024", settings, results, [ & ]( )
+		{
+			matrix.setCharacterMatrix( figure );
+			do_not_optimize( matrix );
+		} );
+	}
+
+	{
+		CharMatrix<> matrix { Y_AxisLen, X_AxisLen, ' ' };
+		bool isWide { };
+
+		run_benchmark( "setX_AxisLen", settings, results, [ & ]( )
+		{
+			isWide = !isWide;
+			matrix.setX_AxisLen( isWide ? X_AxisLen : X_AxisLen / 2 );
+			do_not_optimize( matrix );
+		} );
+	}
+
+	{
+		CharMatrix<> matrix { Y_AxisLen, X_AxisLen, ' ' };
+		bool isTall { };
+
+		run_benchmark( "setY_AxisLen", settings, results, [ & ]( )
+		{
+			isTall = !isTall;
+			matrix.setY_AxisLen( isTall ? Y_AxisLen : Y_AxisLen / 2 );
+			do_not_optimize( matrix );
+		} );
+	}
+
+	// every storage policy draws the same figure
+	const auto run_draw_benchmark { [ & ]< class Matrix >( const std::string_view name, Matrix&& matrix,
+														   const std::span<const coords_type> coordsOfChars )
+	{
+		matrix.setCharacterMatrix( coordsOfChars );
+
+		run_benchmark( name, settings, results, [ & ]( ) { matrix.draw( discarding_stream ); } );
+	} };
+
+	run_draw_benchmark( "draw/dense_36x168", CharMatrix<> { Y_AxisLen, X_AxisLen, ' ' }, figure );
+	run_draw_benchmark( "draw/dense_50x168", CharMatrix<> { max_dense_y_axis_len, max_dense_x_axis_len, ' ' },
+						max_dense_figure );
+	run_draw_benchmark( "draw/strided_50x168",
+						StridedCharMatrix<> { max_dense_y_axis_len, max_dense_x_axis_len, ' ' }, max_dense_figure );
+	run_draw_benchmark( "draw/packed_50x168",
+						PackedCharMatrix<> { max_dense_y_axis_len, max_dense_x_axis_len, ' ' }, max_dense_figure );
+	run_draw_benchmark( "draw/packed_1024x1024", PackedCharMatrix<> { large_axis_len, large_axis_len, ' ' },
+						large_figure );
+	run_draw_benchmark( "draw/tiled_1024x1024", TiledCharMatrix<> { large_axis_len, large_axis_len, ' ' },
+						large_figure );
+
+	{
+		CharMatrix<> matrix { max_dense_y_axis_len, max_dense_x_axis_len, ' ' };
+		matrix.setCharacterMatrix( max_dense_figure );
+
+		const std::string_view characterMatrix { matrix.getCharacterMatrix( ).data( ),
+												 matrix.getCharacterMatrix( ).size( ) };
+		const std::string payload { encode_canvas_payload( characterMatrix, max_dense_x_axis_len, ' ',
+														   Canvas_Encoding::rle ) };
+		const CharMatrix<> blank { max_dense_y_axis_len, max_dense_x_axis_len, ' ' };
+		std::vector<char> decoded;
+
+		run_benchmark( "encode_canvas_payload/rle_50x168", settings, results, [ & ]( )
+		{
+			const std::string encoded { encode_canvas_payload( characterMatrix, max_dense_x_axis_len, ' ',
+															   Canvas_Encoding::rle ) };
+			do_not_optimize( encoded );
+		} );
+
+		run_benchmark( "decode_canvas_payload/rle_50x168", settings, results, [ & ]( )
+		{
+			decoded.assign( blank.getCharacterMatrix( ).begin( ), blank.getCharacterMatrix( ).end( ) );
+			decode_canvas_payload( payload, Canvas_Encoding::rle, max_dense_x_axis_len, decoded );
+			do_not_optimize( decoded );
+		} );
+
+		const std::filesystem::path canvas_file_path { std::filesystem::temp_directory_path( ) /
+													   "peyknowruzi-bench.pncm" };
+
+		run_benchmark( "operator<</canvas_file_50x168", settings, results, [ & ]( )
+		{
+			std::ofstream ofs { canvas_file_path, std::ios_base::binary | std::ios_base::trunc };
+			ofs << matrix;
+		} );
+
+		run_benchmark( "operator>>/canvas_file_50x168", settings, results, [ & ]( )
+		{
+			CharMatrix<> loaded { Y_AxisLen, X_AxisLen, ' ' };
+			std::ifstream ifs { canvas_file_path, std::ios_base::binary };
+			ifs >> loaded;
+			do_not_optimize( loaded );
+		} );
+
+		std::error_code ec;
+		std::filesystem::remove( canvas_file_path, ec );
+	}
+
+	return results;
+}
+
+}
+
+
+namespace pnb = peyknowruzi::bench;
+
+
+int main( int argc, char* argv[] )
+{
+	const std::span<char* const> args { argv, static_cast<std::size_t>( argc ) };
+
+	try
+	{
+		const pnb::BenchmarkSettings settings { pnb::parse_settings( args ) };
+		const std::vector<pnb::BenchmarkResult> results { pnb::run_benchmarks( settings ) };
+
+		pnb::write_json_report( std::cout, settings, results );
+		pnb::write_summary( std::cerr, results );
+	}
+	catch ( const std::bad_alloc& )
+	{
+		std::cerr << "Memory_Exception: Ran out of memory\n";
+		return EXIT_FAILURE;
+	}
+	catch ( const std::exception& ex )
+	{
+		std::cerr << ex.what( ) << '\n';
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,418 @@
+
+// PeykNowruzi - Basic ASCII-Art Generator
+// Copyright (C) 2021-2022 Kasra Hashemi
+
+/*
+
+ This file is part of PeykNowruzi.
+
+ PeykNowruzi is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License,
+ or (at your option) any later version.
+
+ PeykNowruzi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty
+ of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with PeykNowruzi. If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "CanvasFile.hpp"
+#include "CharMatrix.hpp"
+#include "Counters.hpp"
+#include "pch.hpp"
+
+
+namespace peyknowruzi
+{
+
+using std::uint32_t;
+using std::uint64_t;
+using std::size_t;
+
+template < std::integral T >
+[[ nodiscard ]] static constexpr T to_little_endian( const T value ) noexcept
+{
+	if constexpr ( std::endian::native == std::endian::big ) { return std::byteswap( value ); }
+	else { return value; }
+}
+
+[[ nodiscard ]] static CanvasFileHeader to_little_endian( CanvasFileHeader header ) noexcept
+{
+	header.version = to_little_endian( header.version );
+	header.Y_AxisLen = to_little_endian( header.Y_AxisLen );
+	header.X_AxisLen = to_little_endian( header.X_AxisLen );
+	header.payloadOffset = to_little_endian( header.payloadOffset );
+	header.payloadSize = to_little_endian( header.payloadSize );
+
+	return header;
+}
+
+[[ nodiscard ]] CanvasFileHeader
+make_canvas_file_header( const uint32_t Y_AxisLen, const uint32_t X_AxisLen, const char fillCharacter,
+						 const Canvas_Encoding encoding, const uint64_t payloadSize ) noexcept
+{
+	static_assert( sizeof( CanvasFileHeader ) % canvas_payload_alignment == 0 );
+
+	CanvasFileHeader header { };
+	header.magic = canvas_file_magic;
+	header.version = canvas_file_version;
+	header.Y_AxisLen = Y_AxisLen;
+	header.X_AxisLen = X_AxisLen;
+	header.payloadOffset = sizeof( CanvasFileHeader );
+	header.payloadSize = payloadSize;
+	header.fillCharacter = fillCharacter;
+	header.encoding = std::to_underlying( encoding );
+
+	return header;
+}
+
+void write_canvas_file_header( std::ostream& output_stream, const CanvasFileHeader& header )
+{
+	const CanvasFileHeader header_LE { to_little_endian( header ) };
+
+	output_stream.write( reinterpret_cast<const char*>( &header_LE ), sizeof( header_LE ) );
+}
+
+static void append_varint( std::string& payload_OUT, uint64_t value )
+{
+	for ( ; value >= 0x80; value >>= 7 )
+	{
+		payload_OUT.push_back( static_cast<char>( ( value & 0x7F ) | 0x80 ) );
+	}
+
+	payload_OUT.push_back( static_cast<char>( value ) );
+}
+
+[[ nodiscard ]] static uint64_t read_varint( std::string_view& payload )
+{
+	uint64_t value { };
+
+	for ( unsigned shift { }; shift < 64; shift += 7 )
+	{
+		if ( payload.empty( ) ) { break; }
+
+		const auto byte { static_cast<unsigned char>( payload.front( ) ) };
+		payload.remove_prefix( 1 );
+		value |= uint64_t { byte & 0x7Fu } << shift;
+
+		if ( ( byte & 0x80 ) == 0 ) { return value; }
+	}
+
+	throw std::runtime_error( "Canvas_File_Exception: The canvas payload holds a malformed length" );
+}
+
+// walks the cells of a dense matrix without its newline column
+class CellCursor
+{
+public:
+	CellCursor( const std::span<char> characterMatrix, const uint32_t X_AxisLen ) noexcept
+		: m_characterMatrix( characterMatrix ), m_rowLen( X_AxisLen - 1 ), m_X_AxisLen( X_AxisLen )
+	{
+	}
+
+	[[ nodiscard ]] uint64_t getRemainingCellsCount( ) const noexcept
+	{
+		return ( m_characterMatrix.size( ) / m_X_AxisLen - m_offset / m_X_AxisLen ) * m_rowLen - m_offset % m_X_AxisLen;
+	}
+
+	void skip( uint64_t cellsCount ) noexcept
+	{
+		m_offset += cellsCount / m_rowLen * m_X_AxisLen;
+		cellsCount %= m_rowLen;
+
+		const size_t rowEnd { m_offset - m_offset % m_X_AxisLen + m_rowLen };
+		m_offset += cellsCount;
+		if ( m_offset >= rowEnd ) { m_offset += m_X_AxisLen - m_rowLen; }
+	}
+
+	void write( std::string_view cells ) noexcept
+	{
+		while ( !cells.empty( ) )
+		{
+			const size_t rowEnd { m_offset - m_offset % m_X_AxisLen + m_rowLen };
+			const size_t chunkSize { std::min( cells.size( ), rowEnd - m_offset ) };
+
+			std::memcpy( m_characterMatrix.data( ) + m_offset, cells.data( ), chunkSize );
+			cells.remove_prefix( chunkSize );
+			m_offset += chunkSize;
+			if ( m_offset == rowEnd ) { m_offset += m_X_AxisLen - m_rowLen; }
+		}
+	}
+
+private:
+	std::span<char> m_characterMatrix;
+	size_t m_offset { };
+	size_t m_rowLen;
+	size_t m_X_AxisLen;
+};
+
+[[ nodiscard ]] static std::string encode_rle( const std::string_view characterMatrix, const uint32_t X_AxisLen,
+											   const char fillCharacter )
+{
+	std::string payload;
+	std::string literals;
+	uint64_t fillRunLen { };
+
+	for ( size_t rowOffset { }; rowOffset < characterMatrix.size( ); rowOffset += X_AxisLen )
+	{
+		const std::string_view row { characterMatrix.substr( rowOffset, X_AxisLen - 1 ) };
+
+		for ( const char ch : row )
+		{
+			if ( ch == fillCharacter )
+			{
+				if ( !literals.empty( ) )
+				{
+					append_varint( payload, fillRunLen );
+					append_varint( payload, literals.size( ) );
+					payload += literals;
+					literals.clear( );
+					fillRunLen = 0;
+				}
+
+				++fillRunLen;
+			}
+			else
+			{
+				literals.push_back( ch );
+			}
+		}
+	}
+
+	if ( fillRunLen != 0 || !literals.empty( ) )
+	{
+		append_varint( payload, fillRunLen );
+		append_varint( payload, literals.size( ) );
+		payload += literals;
+	}
+
+	return payload;
+}
+
+[[ nodiscard ]] static std::string encode_sparse( const std::string_view characterMatrix, const uint32_t X_AxisLen,
+												  const char fillCharacter )
+{
+	std::string cells;
+	uint64_t cellsCount { };
+	uint64_t cellIndex { };
+	uint64_t lastCellIndex { };
+
+	for ( size_t rowOffset { }; rowOffset < characterMatrix.size( ); rowOffset += X_AxisLen )
+	{
+		const std::string_view row { characterMatrix.substr( rowOffset, X_AxisLen - 1 ) };
+
+		for ( const char ch : row )
+		{
+			if ( ch != fillCharacter )
+			{
+				append_varint( cells, cellIndex - lastCellIndex );
+				cells.push_back( ch );
+				lastCellIndex = cellIndex;
+				++cellsCount;
+			}
+
+			++cellIndex;
+		}
+	}
+
+	std::string payload;
+	payload.reserve( cells.size( ) + 10 );
+	append_varint( payload, cellsCount );
+	payload += cells;
+
+	return payload;
+}
+
+[[ nodiscard ]] std::string encode_canvas_payload( const std::string_view characterMatrix, const uint32_t X_AxisLen,
+												   const char fillCharacter, const Canvas_Encoding encoding )
+{
+	switch ( encoding )
+	{
+		case Canvas_Encoding::raw: return std::string { characterMatrix };
+		case Canvas_Encoding::rle: return encode_rle( characterMatrix, X_AxisLen, fillCharacter );
+		case Canvas_Encoding::sparse: return encode_sparse( characterMatrix, X_AxisLen, fillCharacter );
+	}
+
+	throw std::invalid_argument( "Canvas_File_Exception: Unknown canvas encoding" );
+}
+
+void decode_canvas_payload( std::string_view payload, const Canvas_Encoding encoding, const uint32_t X_AxisLen,
+							const std::span<char> characterMatrix_OUT )
+{
+	static constexpr auto malformed_payload_message { "Canvas_File_Exception: The canvas payload does not match "
+													  "the size of the canvas" };
+
+	if ( encoding == Canvas_Encoding::raw )
+	{
+		if ( payload.size( ) != characterMatrix_OUT.size( ) ) { throw std::runtime_error( malformed_payload_message ); }
+
+		std::memcpy( characterMatrix_OUT.data( ), payload.data( ), payload.size( ) );
+		return;
+	}
+
+	if ( X_AxisLen < 2 || characterMatrix_OUT.size( ) % X_AxisLen != 0 )
+	{
+		throw std::runtime_error( malformed_payload_message );
+	}
+
+	CellCursor cursor { characterMatrix_OUT, X_AxisLen };
+
+	if ( encoding == Canvas_Encoding::rle )
+	{
+		// the matrix already holds the fill character, so only literals are copied
+		while ( !payload.empty( ) )
+		{
+			const uint64_t fillRunLen { read_varint( payload ) };
+			const uint64_t literalsCount { read_varint( payload ) };
+
+			if ( fillRunLen > cursor.getRemainingCellsCount( ) ||
+				 literalsCount > cursor.getRemainingCellsCount( ) - fillRunLen || literalsCount > payload.size( ) )
+			{
+				throw std::runtime_error( malformed_payload_message );
+			}
+
+			cursor.skip( fillRunLen );
+			cursor.write( payload.substr( 0, literalsCount ) );
+			payload.remove_prefix( literalsCount );
+		}
+	}
+	else if ( encoding == Canvas_Encoding::sparse )
+	{
+		const uint64_t cellsCount { read_varint( payload ) };
+
+		for ( uint64_t cellNumber { }; cellNumber < cellsCount; ++cellNumber )
+		{
+			const uint64_t distance { read_varint( payload ) };
+
+			if ( payload.empty( ) || ( cellNumber != 0 && distance == 0 ) ||
+				 distance >= cursor.getRemainingCellsCount( ) + ( cellNumber != 0 ? 1 : 0 ) )
+			{
+				throw std::runtime_error( malformed_payload_message );
+			}
+
+			// the cursor rests one cell past the previous one
+			cursor.skip( cellNumber != 0 ? distance - 1 : distance );
+			cursor.write( payload.substr( 0, 1 ) );
+			payload.remove_prefix( 1 );
+		}
+
+		if ( !payload.empty( ) ) { throw std::runtime_error( malformed_payload_message ); }
+	}
+	else
+	{
+		throw std::runtime_error( "Canvas_File_Exception: Unknown canvas encoding " +
+								  std::to_string( std::to_underlying( encoding ) ) );
+	}
+}
+
+[[ nodiscard ]] CanvasFileHeader read_canvas_file_header( const std::string_view bytes, const uint64_t fileSize )
+{
+	if ( bytes.size( ) < sizeof( CanvasFileHeader ) )
+	{
+		throw std::runtime_error( "Canvas_File_Exception: The canvas file is too short to hold a header" );
+	}
+
+	CanvasFileHeader header;
+	std::memcpy( &header, bytes.data( ), sizeof( header ) );
+	header = to_little_endian( header );
+
+	if ( header.magic != canvas_file_magic )
+	{
+		throw std::runtime_error( "Canvas_File_Exception: The file is not a PeykNowruzi canvas" );
+	}
+
+	if ( header.version != canvas_file_version )
+	{
+		throw std::runtime_error( "Canvas_File_Exception: Unsupported canvas file version " +
+								  std::to_string( header.version ) );
+	}
+
+	if ( header.payloadOffset < sizeof( CanvasFileHeader ) || header.payloadOffset % canvas_payload_alignment != 0 ||
+		 header.payloadOffset > fileSize || header.payloadSize > fileSize - header.payloadOffset )
+	{
+		throw std::runtime_error( "Canvas_File_Exception: The canvas payload lies outside of the file" );
+	}
+
+	return header;
+}
+
+CanvasView::CanvasView( const std::string& filePath )
+
+	: m_file( filePath ), m_header( read_canvas_file_header( m_file.getContents( ), m_file.getContents( ).size( ) ) ),
+	  m_payload( m_file.getContents( ).substr( m_header.payloadOffset, m_header.payloadSize ) )
+{
+	const uint64_t characterMatrixSize { uint64_t { m_header.Y_AxisLen } * m_header.X_AxisLen };
+
+	if ( m_header.X_AxisLen < CharMatrix<>::min_allowed_x_axis_len ||
+		 ( m_header.encoding == std::to_underlying( Canvas_Encoding::raw ) && m_payload.size( ) != characterMatrixSize ) )
+	{
+		throw std::runtime_error( "Canvas_File_Exception: '" + filePath + "' does not hold a canvas "
+								  "that can be viewed" );
+	}
+
+	if ( m_header.encoding == std::to_underlying( Canvas_Encoding::raw ) ) { return; }
+
+	// only decoding is timed, mapping the file takes about as long for any canvas
+	const util::ScopedTimer timer { latency::Phase::serialize };
+
+	m_decodedPayload.assign( characterMatrixSize, m_header.fillCharacter );
+	for ( size_t newlineOffset { m_header.X_AxisLen - 1 }; newlineOffset < m_decodedPayload.size( );
+		  newlineOffset += m_header.X_AxisLen )
+	{
+		m_decodedPayload[ newlineOffset ] = '\n';
+	}
+
+	decode_canvas_payload( m_payload, static_cast<Canvas_Encoding>( m_header.encoding ), m_header.X_AxisLen,
+						   m_decodedPayload );
+	m_payload = { m_decodedPayload.data( ), m_decodedPayload.size( ) };
+}
+
+[[ nodiscard ]] uint32_t CanvasView::getY_AxisLen( ) const noexcept
+{
+	return m_header.Y_AxisLen;
+}
+
+[[ nodiscard ]] uint32_t CanvasView::getX_AxisLen( ) const noexcept
+{
+	return m_header.X_AxisLen;
+}
+
+[[ nodiscard ]] char CanvasView::getFillCharacter( ) const noexcept
+{
+	return m_header.fillCharacter;
+}
+
+[[ nodiscard ]] std::string_view CanvasView::getCharacterMatrix( ) const noexcept
+{
+	return m_payload;
+}
+
+[[ nodiscard ]] char CanvasView::operator[ ]( const size_t X_Axis, const size_t Y_Axis ) const noexcept
+{
+	return m_payload[ Y_Axis * m_header.X_AxisLen + X_Axis ];
+}
+
+void CanvasView::draw( std::ostream& output_stream ) const
+{
+	const util::ScopedTimer timer { latency::Phase::draw };
+
+	if ( std::optional< util::FdOutput > output { util::FdOutput::for_stream( output_stream ) } )
+	{
+		output->append( m_payload );
+		output->flush( );
+	}
+	else
+	{
+		output_stream.write( m_payload.data( ), static_cast<std::streamsize>( m_payload.size( ) ) );
+	}
+
+	counters::add( counters::Counter::bytes_drawn, m_payload.size( ) );
+}
+
+}
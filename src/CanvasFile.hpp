@@ -0,0 +1,116 @@
+
+// PeykNowruzi - Basic ASCII-Art Generator
+// Copyright (C) 2021-2022 Kasra Hashemi
+
+/*
+
+ This file is part of PeykNowruzi.
+
+ PeykNowruzi is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License,
+ or (at your option) any later version.
+
+ PeykNowruzi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty
+ of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with PeykNowruzi. If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+
+#pragma once
+
+#include "pch.hpp"
+#include "Util.hpp"
+
+
+namespace peyknowruzi
+{
+
+// On-disk layout of a saved canvas: a fixed 64 byte header followed by the
+// payload at payloadOffset, which is a multiple of canvas_payload_alignment.
+// All integers are little-endian. A raw payload is the dense matrix as it is
+// drawn, newline column included, so a mapped file can be shown in place. The
+// compressed encodings only cover the Y * ( X - 1 ) cells without the newline
+// column, walked row by row:
+//  - rle: records of a varint run of fill characters, a varint literal length
+//    and that many literal cells
+//  - sparse: a varint count, then per cell that is not the fill character a
+//    varint distance from the previous such cell and the cell itself
+struct CanvasFileHeader
+{
+	std::array<char, 4> magic;
+	std::uint32_t version;
+	std::uint32_t Y_AxisLen;
+	std::uint32_t X_AxisLen;
+	std::uint64_t payloadOffset;
+	std::uint64_t payloadSize;
+	char fillCharacter;
+	std::uint8_t encoding;
+	std::array<std::uint8_t, 30> reserved;
+};
+
+static_assert( sizeof( CanvasFileHeader ) == 64 && std::is_trivially_copyable_v<CanvasFileHeader>,
+			   "CanvasFileHeader has to stay a 64 byte trivially copyable record" );
+
+enum class Canvas_Encoding : std::uint8_t
+{
+	raw = 0,
+	rle = 1,
+	sparse = 2,
+};
+
+inline constexpr std::array<char, 4> canvas_file_magic { 'P', 'N', 'C', 'M' };
+inline constexpr std::uint32_t canvas_file_version { 1 };
+inline constexpr std::size_t canvas_payload_alignment { 64 };
+
+[[ nodiscard ]] CanvasFileHeader
+make_canvas_file_header( const std::uint32_t Y_AxisLen, const std::uint32_t X_AxisLen,
+						 const char fillCharacter, const Canvas_Encoding encoding,
+						 const std::uint64_t payloadSize ) noexcept;
+
+void write_canvas_file_header( std::ostream& output_stream, const CanvasFileHeader& header );
+
+// characterMatrix is the dense matrix, newline column included
+[[ nodiscard ]] std::string encode_canvas_payload( const std::string_view characterMatrix,
+												   const std::uint32_t X_AxisLen, const char fillCharacter,
+												   const Canvas_Encoding encoding );
+
+// characterMatrix_OUT has to hold the dense matrix already filled with the fill
+// character and newlines, only the cells that differ from it are written
+void decode_canvas_payload( const std::string_view payload, const Canvas_Encoding encoding,
+							const std::uint32_t X_AxisLen, const std::span<char> characterMatrix_OUT );
+
+// validates the header at the start of bytes against the size of the whole file
+// and returns it with its fields in host byte order
+[[ nodiscard ]] CanvasFileHeader read_canvas_file_header( const std::string_view bytes,
+														  const std::uint64_t fileSize );
+
+// A saved canvas opened in place: loading maps the file and checks its header,
+// so it takes the same time for every canvas size and the cells are read
+// straight from the mapping. Compressed canvases are decoded once on opening.
+class CanvasView
+{
+public:
+	explicit CanvasView( const std::string& filePath );
+
+	[[ nodiscard ]] std::uint32_t getY_AxisLen( ) const noexcept;
+	[[ nodiscard ]] std::uint32_t getX_AxisLen( ) const noexcept;
+	[[ nodiscard ]] char getFillCharacter( ) const noexcept;
+	[[ nodiscard ]] std::string_view getCharacterMatrix( ) const noexcept;
+	[[ nodiscard ]] char operator[ ]( const std::size_t X_Axis, const std::size_t Y_Axis ) const noexcept;
+
+	void draw( std::ostream& output_stream ) const;
+
+private:
+	util::MappedFile m_file;
+	CanvasFileHeader m_header;
+	std::vector<char> m_decodedPayload;
+	std::string_view m_payload;
+};
+
+}
@@ -23,23 +23,27 @@
 
 
 #include "CharMatrix.hpp"
+#include "CanvasFile.hpp"
+#include "Counters.hpp"
+#include "FixedCharMatrix.hpp"
+#include "RenderCache.hpp"
 #include "pch.hpp"
 #include "Log.hpp"
 #include "Util.hpp"
 
 
 using std::uint32_t;
-using std::int64_t;
+using std::uint64_t;
 using std::size_t;
 using std::streamsize;
 
 namespace peyknowruzi
 {
 
-static constexpr uint32_t min_allowed_y_axis_len { 1 };
-static constexpr uint32_t min_allowed_x_axis_len { 2 };
-static constexpr uint32_t max_allowed_y_axis_len { 50 };
-static constexpr uint32_t max_allowed_x_axis_len { 168 };
+static constexpr uint32_t min_allowed_y_axis_len { CharMatrix<>::min_allowed_y_axis_len };
+static constexpr uint32_t min_allowed_x_axis_len { CharMatrix<>::min_allowed_x_axis_len };
+static constexpr uint32_t max_allowed_y_axis_len { CharMatrix<>::max_allowed_y_axis_len };
+static constexpr uint32_t max_allowed_x_axis_len { CharMatrix<>::max_allowed_x_axis_len };
 static constexpr size_t min_possible_num_of_input_lines { 0 };
 static constexpr size_t max_possible_num_of_input_lines { ( max_allowed_y_axis_len *
 														  ( max_allowed_x_axis_len - 1 ) ) / 2 };
@@ -67,41 +71,65 @@ static_assert( min_possible_num_of_input_lines <= max_allowed_y_axis_len * ( max
 			   "greater than max_possible_num_of_input_lines" );
 
 
-template <class Allocator>
-inline CharMatrix<Allocator>::CharMatrix( const uint32_t Y_AxisLen, const uint32_t X_AxisLen,
-										  const char fillCharacter, const Allocator& alloc )
-
-	: m_Y_AxisLen( Y_AxisLen ), m_X_AxisLen( X_AxisLen ), m_fillCharacter( fillCharacter ),
-	  m_characterMatrix( Y_AxisLen * X_AxisLen, fillCharacter, alloc )
+[[ nodiscard ]] static std::optional< std::string_view >
+get_line_from_input( util::LineReader& input_reader )
 {
-	for ( size_t last_idx_of_row { m_X_AxisLen - 1 }; last_idx_of_row < m_characterMatrix.size( )
-		  ; last_idx_of_row += m_X_AxisLen )
+	static constexpr size_t max_line_len { static_cast<size_t>( default_buffer_size ) - 1 };
+
+	std::optional< std::string_view > line { input_reader.getline( ) };
+
+	if ( line && line->size( ) > max_line_len )
 	{
-		m_characterMatrix[ last_idx_of_row ] = '\n';
+		line->remove_suffix( line->size( ) - max_line_len );
 	}
+
+	return line;
 }
 
-template <class Allocator>
-inline CharMatrix<Allocator>::CharMatrix( CharMatrix<Allocator>&& rhs ) noexcept
+template < class Allocator, template < class > class Storage >
+inline CharMatrix<Allocator, Storage>::CharMatrix( const uint32_t Y_AxisLen, const uint32_t X_AxisLen,
+													   const char fillCharacter, const Allocator& alloc )
+
+	: m_Y_AxisLen( Y_AxisLen ), m_X_AxisLen( X_AxisLen ), m_fillCharacter( fillCharacter ),
+	  m_storage( Y_AxisLen, X_AxisLen, fillCharacter, alloc ),
+	  m_dirtyRowSpans( alloc ), m_areAllRowsDirty( true ), m_contentHash( 0 ), m_isContentHashValid( true )
+{
+}
+
+template < class Allocator, template < class > class Storage >
+inline CharMatrix<Allocator, Storage>::CharMatrix( CharMatrix<Allocator, Storage>&& rhs ) noexcept
 
 	: m_Y_AxisLen( rhs.m_Y_AxisLen ), m_X_AxisLen( rhs.m_X_AxisLen ), m_fillCharacter( rhs.m_fillCharacter ),
-	  m_characterMatrix( std::move( rhs.m_characterMatrix ) )
+	  m_storage( std::move( rhs.m_storage ) ), m_dirtyRowSpans( std::move( rhs.m_dirtyRowSpans ) ),
+	  m_areAllRowsDirty( rhs.m_areAllRowsDirty ), m_contentHash( rhs.m_contentHash ),
+	  m_isContentHashValid( rhs.m_isContentHashValid )
 {
+	rhs.m_dirtyRowSpans.clear( );
+	rhs.m_contentHash = 0;
+	rhs.m_isContentHashValid = true;
 	rhs.m_Y_AxisLen = 0;
 	rhs.m_X_AxisLen = 0;
 	rhs.m_fillCharacter = 0;
 }
 
-template <class Allocator>
-inline CharMatrix<Allocator>& CharMatrix<Allocator>::operator=( CharMatrix<Allocator>&& rhs ) noexcept
+template < class Allocator, template < class > class Storage >
+inline CharMatrix<Allocator, Storage>&
+CharMatrix<Allocator, Storage>::operator=( CharMatrix<Allocator, Storage>&& rhs ) noexcept
 {
 	if ( this != &rhs )
 	{
-		m_characterMatrix = std::move( rhs.m_characterMatrix );
+		m_storage = std::move( rhs.m_storage );
+		m_dirtyRowSpans = std::move( rhs.m_dirtyRowSpans );
+		m_areAllRowsDirty = rhs.m_areAllRowsDirty;
 		m_Y_AxisLen = rhs.m_Y_AxisLen;
 		m_X_AxisLen = rhs.m_X_AxisLen;
 		m_fillCharacter = rhs.m_fillCharacter;
+		m_contentHash = rhs.m_contentHash;
+		m_isContentHashValid = rhs.m_isContentHashValid;
 
+		rhs.m_dirtyRowSpans.clear( );
+		rhs.m_contentHash = 0;
+		rhs.m_isContentHashValid = true;
 		rhs.m_Y_AxisLen = 0;
 		rhs.m_X_AxisLen = 0;
 		rhs.m_fillCharacter = 0;
@@ -110,75 +138,301 @@ inline CharMatrix<Allocator>& CharMatrix<Allocator>::operator=( CharMatrix<Alloc
 	return *this;
 }
 
-template <class Allocator>
-CharMatrix<Allocator>::operator bool( ) const noexcept
+template < class Allocator, template < class > class Storage >
+CharMatrix<Allocator, Storage>::operator bool( ) const noexcept
 {
-	return !m_characterMatrix.empty( );
+	return !m_storage.empty( );
 }
 
-template <class Allocator>
-bool CharMatrix<Allocator>::operator==( const CharMatrix<Allocator>& rhs ) const noexcept
+template < class Allocator, template < class > class Storage >
+bool CharMatrix<Allocator, Storage>::operator==( const CharMatrix<Allocator, Storage>& rhs ) const noexcept
 {
-	return m_Y_AxisLen == rhs.m_Y_AxisLen &&
-		   m_X_AxisLen == rhs.m_X_AxisLen &&
-		   m_fillCharacter == rhs.m_fillCharacter;
+	if ( m_Y_AxisLen != rhs.m_Y_AxisLen ||
+		 m_X_AxisLen != rhs.m_X_AxisLen ||
+		 m_fillCharacter != rhs.m_fillCharacter ) { return false; }
+
+	// two up to date hashes that differ settle it without looking at the cells
+	if ( m_isContentHashValid && rhs.m_isContentHashValid &&
+		 m_contentHash != rhs.m_contentHash ) { return false; }
+
+	return compareCells( rhs ) == 0;
 }
 
-template <class Allocator>
-std::partial_ordering CharMatrix<Allocator>::operator<=>( const CharMatrix<Allocator>& rhs ) const noexcept
+template < class Allocator, template < class > class Storage >
+std::partial_ordering CharMatrix<Allocator, Storage>::operator<=>( const CharMatrix<Allocator, Storage>& rhs ) const noexcept
 {
-	if ( auto cmp { m_Y_AxisLen * m_X_AxisLen <=> rhs.m_Y_AxisLen * rhs.m_X_AxisLen };
+	if ( auto cmp { uint64_t { m_Y_AxisLen } * m_X_AxisLen <=> uint64_t { rhs.m_Y_AxisLen } * rhs.m_X_AxisLen };
 		 cmp != 0 ) { return cmp; }
 
 	if ( auto cmp { m_Y_AxisLen <=> rhs.m_Y_AxisLen };
 		 cmp != 0 ) { return cmp; }
 
-	return ( m_fillCharacter == rhs.m_fillCharacter ) ?
-		   std::partial_ordering::equivalent : std::partial_ordering::unordered;
+	if ( m_fillCharacter != rhs.m_fillCharacter ) { return std::partial_ordering::unordered; }
+
+	// same geometry and fill, so the cells decide, compared row by row
+	return compareCells( rhs );
 }
 
-template <class Allocator>
-char& CharMatrix<Allocator>::operator[ ]( const size_t X_Axis, const size_t Y_Axis ) noexcept
+template < class Allocator, template < class > class Storage >
+[[ nodiscard ]] std::strong_ordering
+CharMatrix<Allocator, Storage>::compareCells( const CharMatrix<Allocator, Storage>& rhs ) const noexcept
+{
+	if constexpr ( std::same_as< storage_type, DenseStorage<Allocator> > )
+	{
+		const std::vector<char, Allocator>& lhsCells { m_storage.getCharacterMatrix( ) };
+		const std::vector<char, Allocator>& rhsCells { rhs.m_storage.getCharacterMatrix( ) };
+
+		const size_t mismatchOffset { util::find_first_mismatch( { lhsCells.data( ), lhsCells.size( ) },
+																 { rhsCells.data( ), rhsCells.size( ) } ) };
+
+		if ( mismatchOffset == lhsCells.size( ) ) { return std::strong_ordering::equal; }
+
+		return static_cast<unsigned char>( lhsCells[ mismatchOffset ] ) <=>
+			   static_cast<unsigned char>( rhsCells[ mismatchOffset ] );
+	}
+	else if constexpr ( std::same_as< storage_type, StridedStorage<Allocator> > )
+	{
+		const std::string_view lhsRows { m_storage.getRows( ) };
+		const std::string_view rhsRows { rhs.m_storage.getRows( ) };
+
+		const size_t mismatchOffset { util::find_first_mismatch( lhsRows, rhsRows ) };
+
+		if ( mismatchOffset == lhsRows.size( ) ) { return std::strong_ordering::equal; }
+
+		return static_cast<unsigned char>( lhsRows[ mismatchOffset ] ) <=>
+			   static_cast<unsigned char>( rhsRows[ mismatchOffset ] );
+	}
+	else
+	{
+		for ( uint32_t Y_Axis { }; Y_Axis < getY_AxisLen( ); ++Y_Axis )
+		{
+			for ( uint32_t X_Axis { }; X_Axis + 1 < getX_AxisLen( ); ++X_Axis )
+			{
+				const char lhsCh { m_storage.at( X_Axis, Y_Axis ) };
+				const char rhsCh { rhs.m_storage.at( X_Axis, Y_Axis ) };
+
+				if ( lhsCh != rhsCh )
+				{
+					return static_cast<unsigned char>( lhsCh ) <=> static_cast<unsigned char>( rhsCh );
+				}
+			}
+		}
+
+		return std::strong_ordering::equal;
+	}
+}
+
+template < class Allocator, template < class > class Storage >
+[[ nodiscard ]] typename CharMatrix<Allocator, Storage>::RowSpan
+CharMatrix<Allocator, Storage>::diffRow( const CharMatrix<Allocator, Storage>& rhs, const uint32_t Y_Axis ) const noexcept
 {
-	return m_characterMatrix[ Y_Axis * getX_AxisLen( ) + X_Axis ];
+	const uint32_t rowLen { getX_AxisLen( ) - 1 };
+
+	if constexpr ( std::same_as< storage_type, DenseStorage<Allocator> > ||
+				   std::same_as< storage_type, StridedStorage<Allocator> > )
+	{
+		const std::string_view lhsRow { &m_storage.at( 0, Y_Axis ), rowLen };
+		const std::string_view rhsRow { &rhs.m_storage.at( 0, Y_Axis ), rowLen };
+
+		const size_t first { util::find_first_mismatch( lhsRow, rhsRow ) };
+
+		if ( first == rowLen ) { return clean_row_span; }
+
+		return { static_cast<uint32_t>( first ), static_cast<uint32_t>( util::find_last_mismatch( lhsRow, rhsRow ) ) };
+	}
+	else
+	{
+		RowSpan rowSpan { clean_row_span };
+
+		for ( uint32_t X_Axis { }; X_Axis < rowLen; ++X_Axis )
+		{
+			if ( m_storage.at( X_Axis, Y_Axis ) != rhs.m_storage.at( X_Axis, Y_Axis ) )
+			{
+				rowSpan.first = std::min( rowSpan.first, X_Axis );
+				rowSpan.last = X_Axis;
+			}
+		}
+
+		return rowSpan;
+	}
 }
 
-template <class Allocator>
-const char& CharMatrix<Allocator>::operator[ ]( const size_t X_Axis, const size_t Y_Axis ) const noexcept
+template < class Allocator, template < class > class Storage >
+[[ nodiscard ]] std::vector<typename CharMatrix<Allocator, Storage>::RowSpan>
+CharMatrix<Allocator, Storage>::diff( const CharMatrix<Allocator, Storage>& rhs ) const
 {
-	return m_characterMatrix[ Y_Axis * getX_AxisLen( ) + X_Axis ];
+	if ( m_Y_AxisLen != rhs.m_Y_AxisLen || m_X_AxisLen != rhs.m_X_AxisLen )
+	{
+		throw std::invalid_argument( "Invalid_Diff_Exception: Only matrices of the same dimensions can be diffed" );
+	}
+
+	std::vector<RowSpan> differingRowSpans( getY_AxisLen( ), clean_row_span );
+
+	for ( uint32_t Y_Axis { }; Y_Axis < getY_AxisLen( ); ++Y_Axis )
+	{
+		differingRowSpans[ Y_Axis ] = diffRow( rhs, Y_Axis );
+	}
+
+	return differingRowSpans;
 }
 
-template <class Allocator>
+template < class Allocator, template < class > class Storage >
+inline typename CharMatrix<Allocator, Storage>::storage_type::reference
+CharMatrix<Allocator, Storage>::operator[ ]( const size_t X_Axis, const size_t Y_Axis )
+noexcept( storage_type::is_nothrow_access )
+{
+	// the cell is handed out for writing, so it counts as changed
+	markDirty( static_cast<uint32_t>( X_Axis ), static_cast<uint32_t>( Y_Axis ) );
+	m_isContentHashValid = false;
+
+	return m_storage.at( X_Axis, Y_Axis );
+}
+
+template < class Allocator, template < class > class Storage >
+inline typename CharMatrix<Allocator, Storage>::storage_type::const_reference
+CharMatrix<Allocator, Storage>::operator[ ]( const size_t X_Axis, const size_t Y_Axis ) const noexcept
+{
+	return m_storage.at( X_Axis, Y_Axis );
+}
+
+template < class Allocator, template < class > class Storage >
 [[ nodiscard ]] inline const uint32_t&
-CharMatrix<Allocator>::getY_AxisLen( ) const noexcept
+CharMatrix<Allocator, Storage>::getY_AxisLen( ) const noexcept
 {
 	return m_Y_AxisLen;
 }
 
-template <class Allocator>
+template < class Allocator, template < class > class Storage >
 [[ nodiscard ]] inline const uint32_t&
-CharMatrix<Allocator>::getX_AxisLen( ) const noexcept
+CharMatrix<Allocator, Storage>::getX_AxisLen( ) const noexcept
 {
 	return m_X_AxisLen;
 }
 
-template <class Allocator>
+template < class Allocator, template < class > class Storage >
 [[ nodiscard ]] inline const char&
-CharMatrix<Allocator>::getFillCharacter( ) const noexcept
+CharMatrix<Allocator, Storage>::getFillCharacter( ) const noexcept
 {
 	return m_fillCharacter;
 }
 
-template <class Allocator>
+template < class Allocator, template < class > class Storage >
 [[ nodiscard ]] inline const std::vector<char, Allocator>&
-CharMatrix<Allocator>::getCharacterMatrix( ) const noexcept
+CharMatrix<Allocator, Storage>::getCharacterMatrix( ) const noexcept
+requires std::same_as< typename CharMatrix<Allocator, Storage>::storage_type, DenseStorage<Allocator> >
 {
-	return m_characterMatrix;
+	return m_storage.getCharacterMatrix( );
 }
 
-template <class Allocator>
-void CharMatrix<Allocator>::setY_AxisLen( const uint32_t Y_AxisLen )
+template < class Allocator, template < class > class Storage >
+[[ nodiscard ]] inline const typename CharMatrix<Allocator, Storage>::storage_type&
+CharMatrix<Allocator, Storage>::getStorage( ) const noexcept
+{
+	return m_storage;
+}
+
+template < class Allocator, template < class > class Storage >
+[[ nodiscard ]] inline typename CharMatrix<Allocator, Storage>::RowSpan
+CharMatrix<Allocator, Storage>::getDirtyRowSpan( const uint32_t Y_Axis ) const noexcept
+{
+	if ( m_areAllRowsDirty )
+	{
+		return getX_AxisLen( ) >= 2 ? RowSpan { 0, getX_AxisLen( ) - 2 } : clean_row_span;
+	}
+
+	return m_dirtyRowSpans.empty( ) ? clean_row_span : m_dirtyRowSpans[ Y_Axis ];
+}
+
+template < class Allocator, template < class > class Storage >
+[[ nodiscard ]] uint64_t CharMatrix<Allocator, Storage>::getContentHash( ) const noexcept
+{
+	if ( m_isContentHashValid ) { return m_contentHash; }
+
+	if constexpr ( std::same_as< storage_type, DenseStorage<Allocator> > )
+	{
+		const std::vector<char, Allocator>& characterMatrix { m_storage.getCharacterMatrix( ) };
+
+		m_contentHash = util::hash_dense_cells( { characterMatrix.data( ), characterMatrix.size( ) },
+												getX_AxisLen( ), getFillCharacter( ) );
+	}
+	else if constexpr ( std::same_as< storage_type, StridedStorage<Allocator> > )
+	{
+		// the padding holds the fill character, so it is skipped like the newlines
+		m_contentHash = util::hash_dense_cells( m_storage.getRows( ), static_cast<uint32_t>( m_storage.getRowStride( ) ),
+												getFillCharacter( ) );
+	}
+	else
+	{
+		m_contentHash = 0;
+
+		for ( uint32_t Y_Axis { }; Y_Axis < getY_AxisLen( ); ++Y_Axis )
+		{
+			for ( uint32_t X_Axis { }; X_Axis + 1 < getX_AxisLen( ); ++X_Axis )
+			{
+				if ( const char ch { m_storage.at( X_Axis, Y_Axis ) }; ch != getFillCharacter( ) )
+				{
+					m_contentHash += util::mix_cell( X_Axis, Y_Axis, ch );
+				}
+			}
+		}
+	}
+
+	m_isContentHashValid = true;
+
+	return m_contentHash;
+}
+
+template < class Allocator, template < class > class Storage >
+[[ nodiscard ]] inline uint64_t
+CharMatrix<Allocator, Storage>::writeCell( const uint32_t X_Axis, const uint32_t Y_Axis, const char ch,
+										   uint64_t& cellsOverwrittenCount_OUT )
+noexcept( storage_type::is_nothrow_access )
+{
+	const char previousCh { std::as_const( m_storage ).at( X_Axis, Y_Axis ) };
+
+	m_storage.at( X_Axis, Y_Axis ) = ch;
+	markDirty( X_Axis, Y_Axis );
+	cellsOverwrittenCount_OUT += previousCh != getFillCharacter( );
+
+	uint64_t contentHashDelta { };
+	if ( previousCh != getFillCharacter( ) ) { contentHashDelta -= util::mix_cell( X_Axis, Y_Axis, previousCh ); }
+	if ( ch != getFillCharacter( ) ) { contentHashDelta += util::mix_cell( X_Axis, Y_Axis, ch ); }
+
+	return contentHashDelta;
+}
+
+template < class Allocator, template < class > class Storage >
+inline void CharMatrix<Allocator, Storage>::markDirty( const uint32_t X_Axis, const uint32_t Y_Axis ) noexcept
+{
+	if ( m_areAllRowsDirty ) { return; }
+
+	if ( m_dirtyRowSpans.empty( ) )
+	{
+		markAllRowsDirty( );
+		return;
+	}
+
+	RowSpan& dirtyRowSpan { m_dirtyRowSpans[ Y_Axis ] };
+
+	dirtyRowSpan.first = std::min( dirtyRowSpan.first, X_Axis );
+	dirtyRowSpan.last = std::max( dirtyRowSpan.last, X_Axis );
+}
+
+template < class Allocator, template < class > class Storage >
+inline void CharMatrix<Allocator, Storage>::markAllRowsDirty( ) noexcept
+{
+	m_areAllRowsDirty = true;
+}
+
+template < class Allocator, template < class > class Storage >
+inline void CharMatrix<Allocator, Storage>::markAllRowsClean( ) const noexcept
+{
+	std::ranges::fill( m_dirtyRowSpans, clean_row_span );
+	m_areAllRowsDirty = false;
+}
+
+template < class Allocator, template < class > class Storage >
+void CharMatrix<Allocator, Storage>::setY_AxisLen( const uint32_t Y_AxisLen )
 {
 	if ( Y_AxisLen > max_allowed_y_axis_len || Y_AxisLen < min_allowed_y_axis_len )
 	{
@@ -193,33 +447,19 @@ void CharMatrix<Allocator>::setY_AxisLen( const uint32_t Y_AxisLen )
 		throw std::invalid_argument( exceptionMsg );
 	}
 
-	const uint32_t& current_Y_AxisLen { getY_AxisLen( ) };
-	const uint32_t& new_Y_AxisLen { Y_AxisLen };
-
-	if ( new_Y_AxisLen == current_Y_AxisLen ) { return; }
+	m_storage.setY_AxisLen( Y_AxisLen );
 
-	if ( new_Y_AxisLen > current_Y_AxisLen )
-	{
-		m_characterMatrix.resize( m_characterMatrix.size( ) + ( new_Y_AxisLen - current_Y_AxisLen ) *
-								  getX_AxisLen( ), getFillCharacter( ) );
-
-		for ( size_t last_idx_of_row { ( current_Y_AxisLen + 1 ) * getX_AxisLen( ) - 1 }
-			  ; last_idx_of_row < m_characterMatrix.size( ); last_idx_of_row += getX_AxisLen( ) )
-		{
-			m_characterMatrix[ last_idx_of_row ] = '\n';
-		}
-	}
-	else
-	{
-		m_characterMatrix.resize( m_characterMatrix.size( ) - ( current_Y_AxisLen - new_Y_AxisLen ) *
-								  getX_AxisLen( ) );
-	}
+	const uint32_t& new_Y_AxisLen { Y_AxisLen };
 
 	m_Y_AxisLen = { new_Y_AxisLen };
+
+	if ( !m_dirtyRowSpans.empty( ) ) { m_dirtyRowSpans.resize( new_Y_AxisLen, clean_row_span ); }
+	markAllRowsDirty( );
+	m_isContentHashValid = false;
 }
 
-template <class Allocator>
-void CharMatrix<Allocator>::setX_AxisLen( const uint32_t X_AxisLen )
+template < class Allocator, template < class > class Storage >
+void CharMatrix<Allocator, Storage>::setX_AxisLen( const uint32_t X_AxisLen )
 {
 	if ( X_AxisLen > max_allowed_x_axis_len || X_AxisLen < min_allowed_x_axis_len )
 	{
@@ -234,48 +474,18 @@ void CharMatrix<Allocator>::setX_AxisLen( const uint32_t X_AxisLen )
 		throw std::invalid_argument( exceptionMsg );
 	}
 
-	const uint32_t& current_X_AxisLen { getX_AxisLen( ) };
-	const uint32_t& new_X_AxisLen { X_AxisLen };
-
-	if ( new_X_AxisLen == current_X_AxisLen ) { return; }
-
-	if ( new_X_AxisLen > current_X_AxisLen )
-	{
-		m_characterMatrix.resize( getY_AxisLen( ) * new_X_AxisLen, getFillCharacter( ) );
-
-		for ( auto new_pos { m_characterMatrix.end( ) - 1 },
-			  old_pos { m_characterMatrix.begin( ) + ( getY_AxisLen( ) - 1 ) * current_X_AxisLen }
-			  ; old_pos >= m_characterMatrix.begin( ); old_pos -= current_X_AxisLen, --new_pos )
-		{
-			*new_pos = '\n';
-
-			new_pos -= new_X_AxisLen - current_X_AxisLen;
-			std::fill_n( new_pos, new_X_AxisLen - current_X_AxisLen, getFillCharacter( ) );
+	m_storage.setX_AxisLen( X_AxisLen );
 
-			new_pos -= current_X_AxisLen - 1;
-			std::copy_n( old_pos, current_X_AxisLen - 1, new_pos );
-		}
-	}
-	else
-	{
-		for ( auto new_pos { m_characterMatrix.begin( ) },
-			  old_pos { m_characterMatrix.begin( ) }
-			  ; old_pos != m_characterMatrix.end( ); old_pos += current_X_AxisLen, ++new_pos )
-		{
-			std::copy_n( old_pos, new_X_AxisLen - 1, new_pos );
-
-			new_pos += new_X_AxisLen - 1;
-			*new_pos = '\n';
-		}
-
-		m_characterMatrix.resize( getY_AxisLen( ) * new_X_AxisLen );
-	}
+	const uint32_t& new_X_AxisLen { X_AxisLen };
 
 	m_X_AxisLen = { new_X_AxisLen };
+
+	markAllRowsDirty( );
+	m_isContentHashValid = false;
 }
 
-template <class Allocator>
-void CharMatrix<Allocator>::setFillCharacter( const char fillCharacter )
+template < class Allocator, template < class > class Storage >
+void CharMatrix<Allocator, Storage>::setFillCharacter( const char fillCharacter )
 {
 	if ( chars_for_drawing.contains( static_cast<AllowedChars>( fillCharacter ) ) )
 	{
@@ -301,28 +511,180 @@ void CharMatrix<Allocator>::setFillCharacter( const char fillCharacter )
 
 	if ( new_fillCharacter == current_fillCharacter ) { return; }
 
-	std::ranges::replace( m_characterMatrix, current_fillCharacter, new_fillCharacter );
+	m_storage.setFillCharacter( new_fillCharacter );
 
 	m_fillCharacter = { new_fillCharacter };
+
+	markAllRowsDirty( );
+	m_isContentHashValid = false;
 }
 
-template <class Allocator>
-inline void CharMatrix<Allocator>::setCharacterMatrix( const std::array<uint32_t, cartesian_components_count>&
-													   coordsOfChar ) noexcept
+template < class Allocator, template < class > class Storage >
+inline void CharMatrix<Allocator, Storage>::setCharacterMatrix( const std::array<uint32_t, cartesian_components_count>&
+													   coordsOfChar )
+noexcept( storage_type::is_nothrow_access )
+{
+	setCharacterMatrix( std::span { &coordsOfChar, 1 } );
+}
+
+template < class Allocator, template < class > class Storage >
+void CharMatrix<Allocator, Storage>::setCharacterMatrix( const std::span< const std::array<uint32_t, cartesian_components_count> >
+												coordsOfChars )
+noexcept( storage_type::is_nothrow_access )
 {
-	const std::optional< AllowedChars > ch { processCoordsToObtainCharType( coordsOfChar ) };
+	const util::ScopedTimer timer { latency::Phase::rasterize };
 
-	if ( const auto& [ x1, y1, x2, y2 ] { coordsOfChar };
-		 ch.has_value( ) && chars_for_drawing.contains( *ch ) )
+	uint64_t cellsWrittenCount { };
+	uint64_t cellsOverwrittenCount { };
+
+	for ( const auto& coordsOfChar : coordsOfChars )
 	{
-		( *this )[ x1, y1 ] = *ch;
-		( *this )[ x2, y2 ] = *ch;
+		const char ch { lookupCharType( coordsOfChar ) };
+
+		if ( const auto& [ x1, y1, x2, y2 ] { coordsOfChar }; ch != '\0' )
+		{
+			m_contentHash += writeCell( x1, y1, ch, cellsOverwrittenCount );
+			m_contentHash += writeCell( x2, y2, ch, cellsOverwrittenCount );
+			cellsWrittenCount += 2;
+		}
 	}
+
+	counters::add( counters::Counter::cells_written, cellsWrittenCount );
+	counters::add( counters::Counter::cells_overwritten, cellsOverwrittenCount );
 }
 
-template <class Allocator>
+struct PendingCell
+{
+	uint32_t X_Axis;
+	uint32_t Y_Axis;
+	char ch;
+};
+
+// what the row band workers hand each other; every thread that rasterizes in
+// row bands keeps its own across documents, so the buckets keep their capacity
+struct RowBandScratch
+{
+	std::vector< std::vector<PendingCell> > buckets;
+	std::vector<uint64_t> contentHashDeltas;
+};
+
+// started by the first document that is split into row bands and kept for the
+// ones after it
+[[ nodiscard ]] static util::WorkerPool& get_row_band_workers( )
+{
+	static util::WorkerPool row_band_workers;
+	return row_band_workers;
+}
+
+template < class Allocator, template < class > class Storage >
+void CharMatrix<Allocator, Storage>::setCharacterMatrixInRowBands( const std::span< const std::array<uint32_t,
+																 cartesian_components_count> > coordsOfChars,
+																 const unsigned threadsCount )
+{
+	// bands start on multiples of row_band_alignment, e.g. on tile rows for the
+	// tiled canvas, so that no two bands share the state at( ) touches
+	static constexpr size_t row_band_alignment { storage_type::row_band_alignment };
+
+	const size_t rowGroupsCount { ( size_t { getY_AxisLen( ) } + row_band_alignment - 1 ) / row_band_alignment };
+	const size_t maxBandsCount { storage_type::supports_concurrent_row_bands ?
+								 std::min( { size_t { threadsCount }, rowGroupsCount,
+											 coordsOfChars.size( ) / min_coords_per_row_band } ) : 1 };
+
+	if ( maxBandsCount <= 1 )
+	{
+		setCharacterMatrix( coordsOfChars );
+		return;
+	}
+
+	const util::ScopedTimer timer { latency::Phase::rasterize };
+
+	// each worker first classifies its own chunk of the coords and buckets the
+	// resulting cells by row band, then writes the band it owns by walking the
+	// buckets of all workers in chunk order, which keeps the last write to every
+	// cell the same as in the serial path
+	const size_t bandLen { ( rowGroupsCount + maxBandsCount - 1 ) / maxBandsCount * row_band_alignment };
+	const size_t bandsCount { ( size_t { getY_AxisLen( ) } + bandLen - 1 ) / bandLen };
+	const size_t chunkLen { ( coordsOfChars.size( ) + bandsCount - 1 ) / bandsCount };
+
+	// without spans markDirty( ) would mark every row dirty from several workers
+	// at once, so that is done up front
+	if ( m_dirtyRowSpans.empty( ) ) { markAllRowsDirty( ); }
+
+	thread_local RowBandScratch scratch;
+
+	std::vector< std::vector<PendingCell> >& buckets { scratch.buckets };
+	buckets.resize( std::max( buckets.size( ), bandsCount * bandsCount ) );
+	for ( std::vector<PendingCell>& bucket : buckets ) { bucket.clear( ); }
+
+	std::vector<uint64_t>& contentHashDeltas { scratch.contentHashDeltas };
+	contentHashDeltas.assign( bandsCount, 0 );
+
+	const auto classify { [ & ]( const size_t workerIdx )
+	{
+		const size_t chunkStart { std::min( workerIdx * chunkLen, coordsOfChars.size( ) ) };
+		const auto chunk { coordsOfChars.subspan( chunkStart, std::min( chunkLen,
+																		 coordsOfChars.size( ) - chunkStart ) ) };
+		const std::span workerBuckets { buckets.data( ) + workerIdx * bandsCount, bandsCount };
+
+		for ( const auto& coordsOfChar : chunk )
+		{
+			const char ch { lookupCharType( coordsOfChar ) };
+
+			if ( ch == '\0' ) { continue; }
+
+			const auto& [ x1, y1, x2, y2 ] { coordsOfChar };
+			workerBuckets[ y1 / bandLen ].push_back( { x1, y1, ch } );
+			workerBuckets[ y2 / bandLen ].push_back( { x2, y2, ch } );
+		}
+	} };
+
+	const auto write { [ & ]( const size_t workerIdx )
+	{
+		uint64_t contentHashDelta { };
+		uint64_t cellsWrittenCount { };
+		uint64_t cellsOverwrittenCount { };
+
+		for ( size_t chunkIdx { }; chunkIdx < bandsCount; ++chunkIdx )
+		{
+			const std::vector<PendingCell>& bucket { buckets[ chunkIdx * bandsCount + workerIdx ] };
+
+			for ( const PendingCell& cell : bucket )
+			{
+				contentHashDelta += writeCell( cell.X_Axis, cell.Y_Axis, cell.ch, cellsOverwrittenCount );
+			}
+
+			cellsWrittenCount += bucket.size( );
+		}
+
+		contentHashDeltas[ workerIdx ] = contentHashDelta;
+		counters::add( counters::Counter::cells_written, cellsWrittenCount );
+		counters::add( counters::Counter::cells_overwritten, cellsOverwrittenCount );
+	} };
+
+	// two jobs instead of a barrier between the steps, so that a worker that
+	// throws while bucketing can not leave the others waiting for it
+	util::WorkerPool& row_band_workers { get_row_band_workers( ) };
+	row_band_workers.run( bandsCount, classify );
+
+	try
+	{
+		row_band_workers.run( bandsCount, write );
+	}
+	catch ( ... )
+	{
+		// some bands may be written already, with their deltas lost
+		m_isContentHashValid = false;
+		throw;
+	}
+
+	// the deltas of the bands are summed once the workers are done so that
+	// they never contend on the shared hash
+	for ( const uint64_t contentHashDelta : contentHashDeltas ) { m_contentHash += contentHashDelta; }
+}
+
+template < class Allocator, template < class > class Storage >
 [[ nodiscard ]] bool
-CharMatrix<Allocator>::validateEnteredMatrixAttributes( const std::string_view str_enteredMatrixAttributes,
+CharMatrix<Allocator, Storage>::validateEnteredMatrixAttributes( const std::string_view str_enteredMatrixAttributes,
 														std::tuple<uint32_t, uint32_t, char>&
 														tuple_enteredMatrixAttributes_OUT ) noexcept
 {
@@ -366,106 +728,59 @@ CharMatrix<Allocator>::validateEnteredMatrixAttributes( const std::string_view s
 	return isValid;
 }
 
-template <class Allocator>
+template < class Allocator, template < class > class Storage >
 [[ nodiscard ]] bool
-CharMatrix<Allocator>::validateEnteredCoords( const std::string_view str_enteredCoords,
+CharMatrix<Allocator, Storage>::validateEnteredCoords( const std::string_view str_enteredCoords,
 											  std::array<uint32_t, cartesian_components_count>&
 											  int_enteredCoords_OUT ) const noexcept
 {
-	static constexpr size_t required_tokens_count { cartesian_components_count };
-	static constexpr std::array<size_t, 2> specificTokensIndicesFor_Y { 1, 3 };
-	static constexpr std::array<size_t, 2> specificTokensIndicesFor_X { 0, 2 };
-
 	const uint32_t max_allowed_y { getY_AxisLen( ) - 1 };
 	const uint32_t max_allowed_x { getX_AxisLen( ) - 2 };
-	static constexpr uint32_t min_allowed_y { 0 };
-	static constexpr uint32_t min_allowed_x { 0 };
 
-	std::array< std::string_view, required_tokens_count > foundTokens;
+	const std::array<uint32_t, cartesian_components_count> maxAllowedCoords { max_allowed_x, max_allowed_y,
+																			   max_allowed_x, max_allowed_y };
 
-	const size_t foundTokensCount { util::tokenize_fast( str_enteredCoords, foundTokens,
-														 required_tokens_count ) };
-
-	const bool isValid
-	{
-		foundTokensCount == required_tokens_count
-																									&&
-		util::convert_specific_tokens_to_integers<uint32_t>( foundTokens, int_enteredCoords_OUT,
-															 specificTokensIndicesFor_Y,
-															 { min_allowed_y, max_allowed_y } )
-																									&&
-		util::convert_specific_tokens_to_integers<uint32_t>( foundTokens, int_enteredCoords_OUT,
-															 specificTokensIndicesFor_X,
-															 { min_allowed_x, max_allowed_x } )
-	};
+	const bool isValid { util::parse_uint32_quad( str_enteredCoords, int_enteredCoords_OUT, maxAllowedCoords ) };
 
 	return isValid;
 }
 
-template <class Allocator>
-[[ nodiscard ]] inline std::optional< typename CharMatrix<Allocator>::AllowedChars >
-CharMatrix<Allocator>::processCoordsToObtainCharType( const std::array<uint32_t, cartesian_components_count>&
+template < class Allocator, template < class > class Storage >
+[[ nodiscard ]] inline std::optional< typename CharMatrix<Allocator, Storage>::AllowedChars >
+CharMatrix<Allocator, Storage>::processCoordsToObtainCharType( const std::array<uint32_t, cartesian_components_count>&
 													  coordsOfChar ) noexcept
 {
-	const auto& [ x1, y1, x2, y2 ] { coordsOfChar };
+	const char ch { lookupCharType( coordsOfChar ) };
 
-	const bool isDifferenceOfX_AxisLensEqualTo_1 { std::abs( static_cast<int64_t>( x1 ) -
-															 static_cast<int64_t>( x2 ) ) == 1 };
+	if ( ch == '\0' ) { return std::nullopt; }
 
-	const bool isDifferenceOfY_AxisLensEqualTo_1 { std::abs( static_cast<int64_t>( y1 ) -
-															 static_cast<int64_t>( y2 ) ) == 1 };
-
-	if ( isDifferenceOfX_AxisLensEqualTo_1 &&
-		 ( y1 == y2 ) )
-	{
-		return Dash;
-	}
-	else if ( isDifferenceOfY_AxisLensEqualTo_1 &&
-			  ( x1 == x2 ) )
-	{
-		return VerticalSlash;
-	}
-	else if ( isDifferenceOfX_AxisLensEqualTo_1 &&
-			  isDifferenceOfY_AxisLensEqualTo_1 &&
-			  ( ( x1 < x2 && y1 > y2 ) ||
-				( x1 > x2 && y1 < y2 ) ) )
-	{
-		return ForwardSlash;
-	}
-	else if ( isDifferenceOfX_AxisLensEqualTo_1 &&
-			  isDifferenceOfY_AxisLensEqualTo_1 &&
-			  ( ( x1 < x2 && y1 < y2 ) ||
-				( x1 > x2 && y1 > y2 ) ) )
-	{
-		return BackSlash;
-	}
-	else
-	{
-		return std::nullopt;
-	}
+	return static_cast<AllowedChars>( ch );
 }
 
-template <class Allocator>
-size_t CharMatrix<Allocator>::getNumOfInputLines( ) const
+template < class Allocator, template < class > class Storage >
+size_t CharMatrix<Allocator, Storage>::getNumOfInputLines( util::LineReader& input_reader ) const
 {
-	const size_t max_allowed_num_of_input_lines { ( getY_AxisLen( ) * ( getX_AxisLen( ) - 1 ) ) / 2 };
+	const size_t max_allowed_num_of_input_lines { ( size_t { getY_AxisLen( ) } * ( getX_AxisLen( ) - 1 ) ) / 2 };
 	const size_t min_allowed_num_of_input_lines { min_possible_num_of_input_lines };
 
-	static constexpr streamsize stream_size { default_buffer_size };
 	static constexpr size_t required_tokens_count { 1 };
 
-	std::array<char, stream_size> str_numOfInputLines { };
 	std::array<size_t, required_tokens_count> int_numOfInputLines { };
 	std::array< std::string_view, required_tokens_count > foundTokens;
 
-	bool isValid;
+	counters::ScopedCount retriesCount { counters::Counter::input_retries };
+	bool isValid { true };
 
 	do
 	{
-		const size_t lengthOfInputStr { util::get_chars_from_input( std::cin, str_numOfInputLines ) };
+		if ( !isValid ) { ++retriesCount; }
+
+		const std::optional< std::string_view > str_numOfInputLines { get_line_from_input( input_reader ) };
+
+		if ( !str_numOfInputLines ) { return min_allowed_num_of_input_lines; }
 
-		const size_t foundTokensCount { util::tokenize_fast( { str_numOfInputLines.data( ), lengthOfInputStr },
-															 foundTokens, required_tokens_count ) };
+		const size_t foundTokensCount { util::tokenize_fast( *str_numOfInputLines, foundTokens,
+															 required_tokens_count ) };
 
 		isValid = foundTokensCount == required_tokens_count &&
 				  util::convert_tokens_to_integers<size_t>( foundTokens, int_numOfInputLines,
@@ -477,21 +792,32 @@ size_t CharMatrix<Allocator>::getNumOfInputLines( ) const
 	return int_numOfInputLines[0];
 }
 
-template <class Allocator>
-auto CharMatrix<Allocator>::getMatrixAttributes( )
+template < class Allocator, template < class > class Storage >
+auto CharMatrix<Allocator, Storage>::getMatrixAttributes( util::LineReader& input_reader )
 {
-	static constexpr streamsize stream_size { default_buffer_size };
+	return tryGetMatrixAttributes( input_reader ).value_or( std::tuple<uint32_t, uint32_t, char> {
+																default_y_axis_len, default_x_axis_len,
+																default_fill_character } );
+}
 
-	std::array<char, stream_size> str_enteredMatrixAttributes { };
+template < class Allocator, template < class > class Storage >
+std::optional< std::tuple<uint32_t, uint32_t, char> >
+CharMatrix<Allocator, Storage>::tryGetMatrixAttributes( util::LineReader& input_reader )
+{
 	std::tuple<uint32_t, uint32_t, char> tuple_enteredMatrixAttributes { };
 
-	bool isAcceptable;
+	counters::ScopedCount retriesCount { counters::Counter::input_retries };
+	bool isAcceptable { true };
 
 	do
 	{
-		const size_t lengthOfInputStr { util::get_chars_from_input( std::cin, str_enteredMatrixAttributes ) };
+		if ( !isAcceptable ) { ++retriesCount; }
+
+		const std::optional< std::string_view > str_enteredMatrixAttributes { get_line_from_input( input_reader ) };
 
-		isAcceptable = validateEnteredMatrixAttributes( { str_enteredMatrixAttributes.data( ), lengthOfInputStr },
+		if ( !str_enteredMatrixAttributes ) { return std::nullopt; }
+
+		isAcceptable = validateEnteredMatrixAttributes( *str_enteredMatrixAttributes,
 														tuple_enteredMatrixAttributes );
 
 	} while ( !isAcceptable );
@@ -499,96 +825,255 @@ auto CharMatrix<Allocator>::getMatrixAttributes( )
 	return tuple_enteredMatrixAttributes;
 }
 
-template <class Allocator>
-void CharMatrix<Allocator>::getCoords( )
+template < class Allocator, template < class > class Storage >
+void CharMatrix<Allocator, Storage>::getCoords( util::LineReader& input_reader, const unsigned threadsCount )
 {
-	const size_t numOfInputLines { getNumOfInputLines( ) };
+	if ( threadsCount > 1 )
+	{
+		// the row bands need every coords up front, so they are all parsed first
+		std::vector< std::array<uint32_t, cartesian_components_count> > coordsOfChars;
+		getCoords( input_reader, coordsOfChars );
+
+		setCharacterMatrixInRowBands( coordsOfChars, threadsCount );
+		return;
+	}
+
+	const size_t numOfInputLines { getNumOfInputLines( input_reader ) };
+
+	static constexpr size_t batch_len { 256 };
+
+	std::array< std::array<uint32_t, cartesian_components_count>, batch_len > coordsBatch;
+	size_t coordsBatchCount { };
 
-	static constexpr streamsize stream_size { default_buffer_size };
-	static constexpr size_t required_tokens_count { cartesian_components_count };
+	// restarted for every batch, so that rasterizing it is not counted as validation
+	std::optional< util::ScopedTimer > batchTimer { std::in_place, latency::Phase::validate };
 
-	std::array<char, stream_size> str_enteredCoords { };
-	std::array<uint32_t, required_tokens_count> int_enteredCoords { };
+	// every rejected line is read again, so the two counts are the same here
+	counters::ScopedCount rejectedLinesCount { counters::Counter::coords_lines_rejected };
+	counters::ScopedCount retriesCount { counters::Counter::input_retries };
 
 	for ( size_t counter { }; counter < numOfInputLines; ++counter )
 	{
-		bool isAcceptable;
+		bool isAcceptable { true };
 
 		do
 		{
-			const size_t lengthOfInputStr { util::get_chars_from_input( std::cin, str_enteredCoords ) };
+			if ( !isAcceptable ) { ++rejectedLinesCount; ++retriesCount; }
 
-			isAcceptable = validateEnteredCoords( { str_enteredCoords.data( ), lengthOfInputStr },
-												  int_enteredCoords );
+			const std::optional< std::string_view > str_enteredCoords { get_line_from_input( input_reader ) };
+
+			if ( !str_enteredCoords )
+			{
+				batchTimer.reset( );
+				setCharacterMatrix( std::span { coordsBatch.data( ), coordsBatchCount } );
+				return;
+			}
+
+			isAcceptable = validateEnteredCoords( *str_enteredCoords, coordsBatch[ coordsBatchCount ] );
 
 		} while ( !isAcceptable );
 
-		setCharacterMatrix( int_enteredCoords );
+		if ( ++coordsBatchCount == batch_len )
+		{
+			batchTimer.reset( );
+			setCharacterMatrix( coordsBatch );
+			coordsBatchCount = 0;
+			batchTimer.emplace( latency::Phase::validate );
+		}
 	}
+
+	batchTimer.reset( );
+	setCharacterMatrix( std::span { coordsBatch.data( ), coordsBatchCount } );
 }
 
-template <class Allocator>
-inline void CharMatrix<Allocator>::draw( std::ostream& output_stream ) const
+template < class Allocator, template < class > class Storage >
+void CharMatrix<Allocator, Storage>::getCoords( util::LineReader& input_reader,
+												std::vector< std::array<uint32_t, cartesian_components_count> >&
+												coordsOfChars_OUT ) const
 {
-#if PN_DEBUG == 1
+	const util::ScopedTimer timer { latency::Phase::validate };
+
+	const size_t numOfInputLines { getNumOfInputLines( input_reader ) };
+
+	coordsOfChars_OUT.clear( );
+	coordsOfChars_OUT.reserve( numOfInputLines );
+
+	counters::ScopedCount rejectedLinesCount { counters::Counter::coords_lines_rejected };
+	counters::ScopedCount retriesCount { counters::Counter::input_retries };
+
+	for ( size_t counter { }; counter < numOfInputLines; ++counter )
 	{
+		std::array<uint32_t, cartesian_components_count> coordsOfChar;
+		bool isAcceptable { true };
+
+		do
+		{
+			if ( !isAcceptable ) { ++rejectedLinesCount; ++retriesCount; }
+
+			const std::optional< std::string_view > str_enteredCoords { get_line_from_input( input_reader ) };
+
+			if ( !str_enteredCoords ) { return; }
+
+			isAcceptable = validateEnteredCoords( *str_enteredCoords, coordsOfChar );
+
+		} while ( !isAcceptable );
+
+		coordsOfChars_OUT.push_back( coordsOfChar );
+	}
+}
+
+template < class Allocator, template < class > class Storage >
+inline void CharMatrix<Allocator, Storage>::draw( std::ostream& output_stream ) const
+{
+	{
+#if PN_DEBUG == 1
 	util::ScopedTimer timer;
 #endif
+	const util::ScopedTimer drawTimer { latency::Phase::draw };
 
-	output_stream.write( getCharacterMatrix( ).data( ), static_cast<streamsize>(
-						 getCharacterMatrix( ).size( ) ) );
+	if ( std::optional< util::FdOutput > output { util::FdOutput::for_stream( output_stream ) } )
+	{
+		m_storage.draw( *output );
+	}
+	else
+	{
+		m_storage.draw( output_stream );
+	}
 
-#if PN_DEBUG == 1
+	counters::add( counters::Counter::bytes_drawn, size_t { getY_AxisLen( ) } * getX_AxisLen( ) );
+	markAllRowsClean( );
 	}
-#endif
 
 	log( "\nFinished." );
 	WAIT;
 }
 
+template < class Allocator, template < class > class Storage >
+void CharMatrix<Allocator, Storage>::drawChanges( std::ostream& output_stream ) const
+{
+	const util::ScopedTimer timer { latency::Phase::draw };
+
+	// every changed span is preceded by a cursor positioning escape, so a
+	// terminal that shows the previous draw only receives what differs from it
+	std::string frame;
+
+	for ( uint32_t Y_Axis { }; Y_Axis < getY_AxisLen( ); ++Y_Axis )
+	{
+		const RowSpan dirtyRowSpan { getDirtyRowSpan( Y_Axis ) };
+
+		if ( dirtyRowSpan.first > dirtyRowSpan.last ) { continue; }
+
+		frame += "\x1b[";
+		frame += std::to_string( Y_Axis + 1 );
+		frame += ';';
+		frame += std::to_string( dirtyRowSpan.first + 1 );
+		frame += 'H';
+
+		for ( uint32_t X_Axis { dirtyRowSpan.first }; X_Axis <= dirtyRowSpan.last; ++X_Axis )
+		{
+			frame += ( *this )[ X_Axis, Y_Axis ];
+		}
+	}
+
+	output_stream.write( frame.data( ), static_cast<streamsize>( frame.size( ) ) );
+	output_stream.flush( );
+
+	counters::add( counters::Counter::bytes_drawn, frame.size( ) );
+
+	// from now on changes are tracked per row, so the next call only sends them
+	if ( m_dirtyRowSpans.empty( ) ) { m_dirtyRowSpans.resize( getY_AxisLen( ), clean_row_span ); }
+	markAllRowsClean( );
+}
+
 template <class Allocator>
-std::ofstream& operator<<( std::ofstream& ofs, const CharMatrix<Allocator>& char_matrix )
+std::ofstream& operator<<( std::ofstream& ofs, const CharMatrix<Allocator, DenseStorage>& char_matrix )
 {
-	ofs.write( reinterpret_cast<const char*>( &char_matrix.getY_AxisLen( ) ),
-			   sizeof( char_matrix.getY_AxisLen( ) ) );
-	ofs.write( reinterpret_cast<const char*>( &char_matrix.getX_AxisLen( ) ),
-			   sizeof( char_matrix.getX_AxisLen( ) ) );
-	ofs.write( reinterpret_cast<const char*>( &char_matrix.getFillCharacter( ) ),
-			   sizeof( char_matrix.getFillCharacter( ) ) );
-	ofs.write( reinterpret_cast<const char*>( char_matrix.getCharacterMatrix( ).data( ) ),
-					 static_cast<streamsize>( char_matrix.getCharacterMatrix( ).size( ) ) );
+	const util::ScopedTimer timer { latency::Phase::serialize };
+
+	const std::vector<char, Allocator>& characterMatrix { char_matrix.getCharacterMatrix( ) };
+	const std::string_view rawPayload { characterMatrix.data( ), characterMatrix.size( ) };
+
+	// whichever encoding is smallest wins, raw on a tie so that the file can
+	// still be viewed in place
+	Canvas_Encoding encoding { Canvas_Encoding::raw };
+	std::string compressedPayload;
+
+	for ( const Canvas_Encoding candidate : { Canvas_Encoding::rle, Canvas_Encoding::sparse } )
+	{
+		std::string payload { encode_canvas_payload( rawPayload, static_cast<uint32_t>( char_matrix.getX_AxisLen( ) ),
+													 char_matrix.getFillCharacter( ), candidate ) };
+
+		if ( payload.size( ) < ( encoding == Canvas_Encoding::raw ? rawPayload.size( ) : compressedPayload.size( ) ) )
+		{
+			encoding = candidate;
+			compressedPayload = std::move( payload );
+		}
+	}
+
+	const std::string_view payload { encoding == Canvas_Encoding::raw ? rawPayload
+																	  : std::string_view { compressedPayload } };
+
+	write_canvas_file_header( ofs, make_canvas_file_header( char_matrix.getY_AxisLen( ), char_matrix.getX_AxisLen( ),
+															char_matrix.getFillCharacter( ), encoding,
+															payload.size( ) ) );
+	ofs.write( payload.data( ), static_cast<streamsize>( payload.size( ) ) );
 
 	return ofs;
 }
 
 template <class Allocator>
-std::ifstream& operator>>( std::ifstream& ifs, CharMatrix<Allocator>& char_matrix )
-{
-	static CharMatrix<Allocator> temp_char_matrix { CharMatrix<Allocator>::default_y_axis_len,
-													CharMatrix<Allocator>::default_x_axis_len,
-													CharMatrix<Allocator>::default_fill_character };
-
-	ifs.read( reinterpret_cast<char*>( &temp_char_matrix.m_Y_AxisLen ),
-			  sizeof( temp_char_matrix.m_Y_AxisLen ) );
-	ifs.read( reinterpret_cast<char*>( &temp_char_matrix.m_X_AxisLen ),
-			  sizeof( temp_char_matrix.m_X_AxisLen ) );
-	ifs.read( reinterpret_cast<char*>( &temp_char_matrix.m_fillCharacter ),
-			  sizeof( temp_char_matrix.m_fillCharacter ) );
-	temp_char_matrix.m_characterMatrix.resize( temp_char_matrix.getY_AxisLen( ) *
-											   temp_char_matrix.getX_AxisLen( ) );
-	ifs.read( reinterpret_cast<char*>( temp_char_matrix.m_characterMatrix.data( ) ),
-			  static_cast<streamsize>( temp_char_matrix.m_characterMatrix.size( ) ) );
-
-	char_matrix.m_Y_AxisLen = temp_char_matrix.getY_AxisLen( );
-	char_matrix.setY_AxisLen( temp_char_matrix.getY_AxisLen( ) );
-	char_matrix.m_X_AxisLen = temp_char_matrix.getX_AxisLen( );
-	char_matrix.setX_AxisLen( temp_char_matrix.getX_AxisLen( ) );
-	char_matrix.m_fillCharacter = temp_char_matrix.getFillCharacter( );
-	char_matrix.setFillCharacter( temp_char_matrix.getFillCharacter( ) );
-	char_matrix.m_characterMatrix.reserve( temp_char_matrix.getCharacterMatrix( ).size( ) );
-	char_matrix.m_characterMatrix.clear( );
-	std::ranges::copy( temp_char_matrix.getCharacterMatrix( ),
-					   std::back_inserter( char_matrix.m_characterMatrix ) );
+std::ifstream& operator>>( std::ifstream& ifs, CharMatrix<Allocator, DenseStorage>& char_matrix )
+{
+	const util::ScopedTimer timer { latency::Phase::serialize };
+
+	std::array<char, sizeof( CanvasFileHeader )> headerBytes;
+
+	if ( !ifs.read( headerBytes.data( ), static_cast<streamsize>( headerBytes.size( ) ) ) ) { return ifs; }
+
+	const CanvasFileHeader header { read_canvas_file_header( { headerBytes.data( ), headerBytes.size( ) },
+															 std::numeric_limits<uint64_t>::max( ) ) };
+
+	using char_matrix_type = CharMatrix<Allocator, DenseStorage>;
+
+	if ( header.Y_AxisLen < char_matrix_type::min_allowed_y_axis_len ||
+		 header.Y_AxisLen > char_matrix_type::max_allowed_y_axis_len ||
+		 header.X_AxisLen < char_matrix_type::min_allowed_x_axis_len ||
+		 header.X_AxisLen > char_matrix_type::max_allowed_x_axis_len ||
+		 header.payloadSize > uint64_t { header.Y_AxisLen } * header.X_AxisLen ||
+		 ( header.encoding == std::to_underlying( Canvas_Encoding::raw ) &&
+		   header.payloadSize != uint64_t { header.Y_AxisLen } * header.X_AxisLen ) )
+	{
+		throw std::runtime_error( "Canvas_File_Exception: The canvas does not fit in a dense CharMatrix" );
+	}
+
+	ifs.ignore( static_cast<streamsize>( header.payloadOffset - sizeof( CanvasFileHeader ) ) );
+
+	// the payload is read straight into the new storage, which only replaces
+	// the current one once it has arrived in full
+	DenseStorage<Allocator> storage { header.Y_AxisLen, header.X_AxisLen, header.fillCharacter,
+									  char_matrix.m_storage.get_allocator( ) };
+
+	if ( header.encoding == std::to_underlying( Canvas_Encoding::raw ) )
+	{
+		if ( !ifs.read( storage.getCharacterMatrix( ).data( ),
+						static_cast<streamsize>( storage.getCharacterMatrix( ).size( ) ) ) ) { return ifs; }
+	}
+	else
+	{
+		std::string payload( header.payloadSize, '\0' );
+		if ( !ifs.read( payload.data( ), static_cast<streamsize>( payload.size( ) ) ) ) { return ifs; }
+
+		decode_canvas_payload( payload, static_cast<Canvas_Encoding>( header.encoding ), header.X_AxisLen,
+							   storage.getCharacterMatrix( ) );
+	}
+
+	char_matrix.m_Y_AxisLen = header.Y_AxisLen;
+	char_matrix.m_X_AxisLen = header.X_AxisLen;
+	char_matrix.m_fillCharacter = header.fillCharacter;
+	char_matrix.m_storage = std::move( storage );
+	char_matrix.m_dirtyRowSpans.clear( );
+	char_matrix.markAllRowsDirty( );
+	char_matrix.m_isContentHashValid = false;
 
 	return ifs;
 }
@@ -598,12 +1083,305 @@ inline void initialize( )
 	std::ios_base::sync_with_stdio( false );
 }
 
-void runScript( )
+static void write_rendered_output( std::ostream& output_stream, const std::string_view renderedOutput )
+{
+	if ( std::optional< util::FdOutput > output { util::FdOutput::for_stream( output_stream ) } )
+	{
+		output->append( renderedOutput );
+		output->flush( );
+	}
+	else
+	{
+		output_stream.write( renderedOutput.data( ), static_cast<streamsize>( renderedOutput.size( ) ) );
+	}
+}
+
+// whether a canvas fits the dense storage, the batch modes draw any other one
+// on a tiled canvas, which only allocates the tiles that get drawn on
+[[ nodiscard ]] static constexpr bool fits_dense_canvas( const uint32_t Y_AxisLen, const uint32_t X_AxisLen ) noexcept
+{
+	return Y_AxisLen <= max_allowed_y_axis_len && X_AxisLen <= max_allowed_x_axis_len;
+}
+
+// draws coordsOfChars on matrix unless the cache already holds what that draws
+// to, returns the new rendering so that the caller can store it once written
+template <class Matrix>
+[[ nodiscard ]] static std::optional< std::string_view >
+render_through_cache( RenderCache& render_cache, Matrix& matrix,
+					  const std::span< const std::array<uint32_t, CharMatrix<>::cartesian_components_count> >
+					  coordsOfChars, const unsigned threadsCount, const RenderKey& key, std::string& renderedOutput_OUT )
+{
+	if ( const std::optional< std::string_view > cachedOutput { render_cache.find( key ) } ) { return cachedOutput; }
+
+	matrix.setCharacterMatrixInRowBands( coordsOfChars, threadsCount );
+
+	std::ostringstream rendered_stream;
+	matrix.draw( rendered_stream );
+	renderedOutput_OUT = std::move( rendered_stream ).str( );
+
+	return std::nullopt;
+}
+
+static void report_render_cache_stats( const RenderCache& render_cache )
+{
+	const RenderCacheStats& stats { render_cache.getStats( ) };
+
+	std::clog << "Render cache: " << stats.memoryHits << " memory hits, " << stats.diskHits << " disk hits, "
+			  << stats.misses << " misses, " << stats.evictions << " evictions\n";
+}
+
+static void render_batch( util::LineReader& input_reader, const unsigned threadsCount,
+						  std::optional< RenderCache >& render_cache )
+{
+	// one arena serves every document, release( ) hands the whole buffer back
+	// after each one so that documents after the first allocate nothing
+	static constexpr size_t required_buffer_size { pmr::CharMatrix::getRequiredBufferSize( max_allowed_y_axis_len,
+																						   max_allowed_x_axis_len ) };
+	std::array< std::byte, required_buffer_size > buffer;
+	std::pmr::monotonic_buffer_resource rsrc { buffer.data( ), buffer.size( ) };
+
+	// only used by the render cache, which has to see the coords before drawing
+	std::vector< std::array<uint32_t, CharMatrix<>::cartesian_components_count> > coordsOfChars;
+	std::string renderedOutput;
+
+	const auto render { [ & ]( auto& matrix )
+	{
+		if ( !render_cache )
+		{
+			matrix.getCoords( input_reader, threadsCount );
+			matrix.draw( std::cout );
+			return;
+		}
+
+		matrix.getCoords( input_reader, coordsOfChars );
+
+		const RenderKey key { make_render_key( matrix.getY_AxisLen( ), matrix.getX_AxisLen( ),
+											   matrix.getFillCharacter( ), coordsOfChars ) };
+
+		if ( const auto cachedOutput { render_through_cache( *render_cache, matrix, coordsOfChars, threadsCount,
+															 key, renderedOutput ) } )
+		{
+			write_rendered_output( std::cout, *cachedOutput );
+		}
+		else
+		{
+			write_rendered_output( std::cout, renderedOutput );
+			render_cache->insert( key, std::move( renderedOutput ) );
+		}
+	} };
+
+	// the attributes are read with the limits of the tiled canvas, which takes
+	// every canvas the dense one is too small for
+	while ( const auto matrixAttributes { TiledCharMatrix<>::tryGetMatrixAttributes( input_reader ) } )
+	{
+		const auto& [ Y_AxisLen, X_AxisLen, fillCharacter ] { *matrixAttributes };
+
+		if ( fits_dense_canvas( Y_AxisLen, X_AxisLen ) )
+		{
+			auto matrix { pmr::CharMatrix( Y_AxisLen, X_AxisLen, fillCharacter, &rsrc ) };
+			render( matrix );
+		}
+		else
+		{
+			auto matrix { TiledCharMatrix<>( Y_AxisLen, X_AxisLen, fillCharacter ) };
+			render( matrix );
+		}
+
+		rsrc.release( );
+	}
+}
+
+static void render_pipelined( const std::optional< util::MappedFile >& input_file, const unsigned threadsCount,
+							  std::optional< RenderCache >& render_cache )
 {
-	// initialize( );
+	// four stages connected by bounded queues: reading, parsing, rasterizing and
+	// writing, so that a document is parsed while the one before it is written;
+	// a stage that stops for any reason closes the queues on both of its sides,
+	// which lets the others run out instead of waiting on it forever
+	static constexpr size_t input_block_size { 1024 * 1024 };
+	static constexpr size_t input_blocks_in_flight { 4 };
+	static constexpr size_t documents_in_flight { 8 };
+
+	using coords_type = std::array<uint32_t, CharMatrix<>::cartesian_components_count>;
+	using matrix_type = std::variant< CharMatrix<>, TiledCharMatrix<> >;
+
+	struct ParsedDocument
+	{
+		matrix_type matrix;
+		std::vector<coords_type> coordsOfChars;
+	};
+
+	// renderedOutput holds the output instead of matrix when it was rendered
+	// through the render cache
+	struct RenderedDocument
+	{
+		matrix_type matrix;
+		std::optional< std::string > renderedOutput;
+	};
+
+	util::BoundedQueue< util::InputBlock > input_blocks { input_blocks_in_flight };
+	util::BoundedQueue< ParsedDocument > parsed_documents { documents_in_flight };
+	util::BoundedQueue< RenderedDocument > rendered_documents { documents_in_flight };
+
+	std::array< std::exception_ptr, 4 > stageExceptions { };
 
+	const auto read_stage { [ & ]( )
+	{
+		if ( input_file )
+		{
+			// the mapping is handed out without copying, its pages are touched here
+			// so that the parse stage does not stall on the page faults
+			const std::string_view contents { input_file->getContents( ) };
+
+			for ( size_t offset { }; offset < contents.size( ); offset += input_block_size )
+			{
+				const std::string_view block { contents.substr( offset, input_block_size ) };
+
+				{
+					const util::ScopedTimer timer { latency::Phase::input };
+
+					for ( size_t page_offset { }; page_offset < block.size( ); page_offset += 4096 )
+					{
+						[[ maybe_unused ]] const volatile char touched { block[ page_offset ] };
+					}
+				}
+
+				if ( !input_blocks.push( util::InputBlock { { }, block } ) ) { return; }
+			}
+		}
+		else
+		{
+			std::streambuf& input_buffer { *std::cin.rdbuf( ) };
+
+			while ( true )
+			{
+				std::vector<char> storage( input_block_size );
+				const std::streamsize readCount { input_buffer.sgetn( storage.data( ),
+																	  static_cast<std::streamsize>( storage.size( ) ) ) };
+
+				if ( readCount <= 0 ) { return; }
+
+				const std::string_view block { storage.data( ), static_cast<size_t>( readCount ) };
+
+				if ( !input_blocks.push( util::InputBlock { std::move( storage ), block } ) ) { return; }
+			}
+		}
+	} };
+
+	const auto parse_stage { [ & ]( )
+	{
+		util::BlockQueueStreambuf input_buffer { input_blocks };
+		std::istream input_stream { &input_buffer };
+		util::LineReader input_reader { input_stream };
+
+		while ( const auto matrixAttributes { TiledCharMatrix<>::tryGetMatrixAttributes( input_reader ) } )
+		{
+			const auto& [ Y_AxisLen, X_AxisLen, fillCharacter ] { *matrixAttributes };
+
+			ParsedDocument document { fits_dense_canvas( Y_AxisLen, X_AxisLen ) ?
+									  matrix_type { CharMatrix<>( Y_AxisLen, X_AxisLen, fillCharacter ) } :
+									  matrix_type { TiledCharMatrix<>( Y_AxisLen, X_AxisLen, fillCharacter ) }, { } };
+			std::visit( [ & ]( const auto& matrix ) { matrix.getCoords( input_reader, document.coordsOfChars ); },
+						document.matrix );
+
+			if ( !parsed_documents.push( std::move( document ) ) ) { return; }
+		}
+	} };
+
+	const auto rasterize_stage { [ & ]( )
+	{
+		while ( std::optional< ParsedDocument > document { parsed_documents.pop( ) } )
+		{
+			RenderedDocument rendered_document { std::move( document->matrix ), std::nullopt };
+
+			std::visit( [ & ]( auto& matrix )
+			{
+				if ( !render_cache )
+				{
+					matrix.setCharacterMatrixInRowBands( document->coordsOfChars, threadsCount );
+					return;
+				}
+
+				const RenderKey key { make_render_key( matrix.getY_AxisLen( ), matrix.getX_AxisLen( ),
+													   matrix.getFillCharacter( ), document->coordsOfChars ) };
+				std::string renderedOutput;
+
+				if ( const auto cachedOutput { render_through_cache( *render_cache, matrix, document->coordsOfChars,
+																	 threadsCount, key, renderedOutput ) } )
+				{
+					rendered_document.renderedOutput.emplace( *cachedOutput );
+				}
+				else
+				{
+					render_cache->insert( key, renderedOutput );
+					rendered_document.renderedOutput.emplace( std::move( renderedOutput ) );
+				}
+			}, rendered_document.matrix );
+
+			if ( !rendered_documents.push( std::move( rendered_document ) ) ) { return; }
+		}
+	} };
+
+	const auto write_stage { [ & ]( )
+	{
+		while ( std::optional< RenderedDocument > rendered_document { rendered_documents.pop( ) } )
+		{
+			if ( rendered_document->renderedOutput )
+			{
+				write_rendered_output( std::cout, *rendered_document->renderedOutput );
+			}
+			else
+			{
+				std::visit( [ ]( const auto& matrix ) { matrix.draw( std::cout ); }, rendered_document->matrix );
+			}
+		}
+	} };
+
+	const auto run_stage { [ & ]( const auto& stage, const size_t stageIdx, auto& input_queue, auto& output_queue )
+	{
+		try
+		{
+			stage( );
+		}
+		catch ( ... )
+		{
+			stageExceptions[ stageIdx ] = std::current_exception( );
+		}
+
+		input_queue.close( );
+		output_queue.close( );
+	} };
+
+	{
+		std::jthread reader { [ & ] { run_stage( read_stage, 0, input_blocks, input_blocks ); } };
+		std::jthread parser { [ & ] { run_stage( parse_stage, 1, input_blocks, parsed_documents ); } };
+		std::jthread rasterizer { [ & ] { run_stage( rasterize_stage, 2, parsed_documents, rendered_documents ); } };
+
+		run_stage( write_stage, 3, rendered_documents, rendered_documents );
+	}
+
+	for ( const std::exception_ptr& stageException : stageExceptions )
+	{
+		if ( stageException ) { std::rethrow_exception( stageException ); }
+	}
+}
+
+static void render_document( const Allocation_Strategy allocationStrategy, util::LineReader& input_reader,
+							 const unsigned threadsCount, std::ostream& output_stream )
+{
 #if FULL_INPUT_MODE == 1
-	const auto [ Y_AxisLen, X_AxisLen, fillCharacter ] { getMatrixAttributes( ) };
+	const auto [ Y_AxisLen, X_AxisLen, fillCharacter ] { TiledCharMatrix<>::getMatrixAttributes( input_reader ) };
+
+	if ( !fits_dense_canvas( Y_AxisLen, X_AxisLen ) )
+	{
+		// too big for a dense canvas, only the tiles that get drawn on will be allocated
+		auto matrix { TiledCharMatrix<>( Y_AxisLen, X_AxisLen, fillCharacter ) };
+
+		matrix.getCoords( input_reader, threadsCount );
+		matrix.draw( output_stream );
+
+		return;
+	}
 #else
 	[[ maybe_unused ]] static constexpr uint32_t Y_AxisLen { 36 };
 	[[ maybe_unused ]] static constexpr uint32_t X_AxisLen { 168 };
@@ -618,53 +1396,224 @@ void runScript( )
 				   "less than min_allowed_x_axis_len" );
 #endif
 
-enum class Allocation_Strategy
-{
-	stack_allocated,
-	stack_heap_allocated,
-	heap_allocated,
-};
+	const auto draw_through_arena { [ & ]( const std::span<std::byte> buffer )
+	{
+		std::pmr::monotonic_buffer_resource rsrc { buffer.data( ), buffer.size( ) };
 
-constexpr Allocation_Strategy alloc_strgy { Allocation_Strategy::stack_allocated };
+		auto matrix { pmr::CharMatrix( Y_AxisLen, X_AxisLen, fillCharacter, &rsrc ) };
 
-if constexpr ( alloc_strgy == Allocation_Strategy::heap_allocated )
-{
-	const auto matrix { std::make_unique< CharMatrix<> >( Y_AxisLen, X_AxisLen , fillCharacter ) };
+		matrix.getCoords( input_reader, threadsCount );
+		matrix.draw( output_stream );
+	} };
 
-	matrix->getCoords( );
-	matrix->draw( std::cout );
-}
-else if constexpr ( alloc_strgy == Allocation_Strategy::stack_heap_allocated )
-{
-	auto matrix { CharMatrix<>( Y_AxisLen, X_AxisLen , fillCharacter ) };
+	switch ( allocationStrategy )
+	{
+		case Allocation_Strategy::heap_allocated:
+		{
+			const auto matrix { std::make_unique< CharMatrix<> >( Y_AxisLen, X_AxisLen , fillCharacter ) };
+
+			matrix->getCoords( input_reader, threadsCount );
+			matrix->draw( output_stream );
+			break;
+		}
+		case Allocation_Strategy::stack_heap_allocated:
+		{
+			auto matrix { CharMatrix<>( Y_AxisLen, X_AxisLen , fillCharacter ) };
+
+			matrix.getCoords( input_reader, threadsCount );
+			matrix.draw( output_stream );
+			break;
+		}
+		case Allocation_Strategy::stack_allocated:
+		{
+#if FULL_INPUT_MODE == 1
+			constexpr size_t required_buffer_size { pmr::CharMatrix::getRequiredBufferSize( max_allowed_y_axis_len,
+																							max_allowed_x_axis_len ) };
+#else
+			constexpr size_t required_buffer_size { pmr::CharMatrix::getRequiredBufferSize( Y_AxisLen, X_AxisLen ) };
+#endif
+			std::array< std::byte, required_buffer_size > buffer;
+
+			draw_through_arena( buffer );
+			break;
+		}
+		case Allocation_Strategy::pool_allocated:
+		{
+			// a pool large enough to serve the cells itself instead of passing them upstream
+			const size_t required_buffer_size { pmr::CharMatrix::getRequiredBufferSize( Y_AxisLen, X_AxisLen ) };
+			std::pmr::unsynchronized_pool_resource rsrc { std::pmr::pool_options { 0, required_buffer_size } };
 
-	matrix.getCoords( );
-	matrix.draw( std::cout );
+			auto matrix { pmr::CharMatrix( Y_AxisLen, X_AxisLen, fillCharacter, &rsrc ) };
+
+			matrix.getCoords( input_reader, threadsCount );
+			matrix.draw( output_stream );
+			break;
+		}
+		case Allocation_Strategy::huge_page_allocated:
+		case Allocation_Strategy::prefaulted:
+		{
+			util::MappedArena arena { pmr::CharMatrix::getRequiredBufferSize( Y_AxisLen, X_AxisLen ),
+									  allocationStrategy == Allocation_Strategy::huge_page_allocated ?
+									  util::Arena_Backing::huge_pages : util::Arena_Backing::prefaulted };
+
+			draw_through_arena( arena.getBuffer( ) );
+			break;
+		}
+	}
 }
-else if constexpr ( alloc_strgy == Allocation_Strategy::stack_allocated )
+
+// runs the same input once under every allocation strategy with the drawings
+// discarded, after one unmeasured run that brings the input into memory
+static void benchmark_allocation_strategies( const std::string_view inputContents, const unsigned threadsCount )
 {
-	constexpr size_t required_buffer_size { Y_AxisLen * X_AxisLen + 500 };
-	std::array< std::byte, required_buffer_size > buffer;
-	std::pmr::monotonic_buffer_resource rsrc { buffer.data( ), buffer.size( ) };
+	static constexpr std::array allocation_strategies { Allocation_Strategy::stack_allocated,
+														Allocation_Strategy::stack_heap_allocated,
+														Allocation_Strategy::heap_allocated,
+														Allocation_Strategy::pool_allocated,
+														Allocation_Strategy::huge_page_allocated,
+														Allocation_Strategy::prefaulted };
+
+	util::DiscardingStreambuf discarding_buffer;
+	std::ostream discarding_stream { &discarding_buffer };
+
+	{
+		util::LineReader input_reader { inputContents };
+		render_document( Allocation_Strategy::stack_allocated, input_reader, threadsCount, discarding_stream );
+	}
+
+	// tab separated so that it can be pasted into a spreadsheet or cut( 1 ) apart
+	std::cout << "strategy\twall time ms\tminor page faults\tmajor page faults\tpeak RSS KiB\n";
 
-	auto matrix { pmr::CharMatrix( Y_AxisLen, X_AxisLen , fillCharacter, &rsrc ) };
+	const std::ios_base::fmtflags coutFlags { std::cout.flags( ) };
+	const std::streamsize coutPrecision { std::cout.precision( 3 ) };
+	std::cout << std::fixed;
+
+	for ( const Allocation_Strategy allocationStrategy : allocation_strategies )
+	{
+		util::LineReader input_reader { inputContents };
+		const util::ResourceUsageMeter meter;
 
-	matrix.getCoords( );
-	matrix.draw( std::cout );
+		render_document( allocationStrategy, input_reader, threadsCount, discarding_stream );
+
+		const util::ResourceUsage usage { meter.getUsage( ) };
+
+		std::cout << to_string( allocationStrategy ) << '\t'
+				  << std::chrono::duration< double, std::milli >{ usage.wallTime }.count( ) << '\t'
+				  << usage.minorPageFaults << '\t' << usage.majorPageFaults << '\t'
+				  << usage.peakResidentSetKiB << '\n';
+	}
+
+	std::cout.flags( coutFlags );
+	std::cout.precision( coutPrecision );
 }
-else
+
+// a kite, rasterized while compiling and kept in the binary as its cells
+static constexpr auto logo_figure { render_fixed_figure<6, 8>( "1 1 2 0\n"
+															   "3 0 4 1\n"
+															   "1 2 2 3\n"
+															   "3 3 4 2\n"
+															   "2 4 2 5\n"
+															   "3 5 4 5\n" ) };
+
+static_assert( logo_figure.getCharacterMatrix( ) == "  /\\   \n"
+													" /  \\  \n"
+													" \\  /  \n"
+													"  \\/   \n"
+													"  |    \n"
+													"  |--  \n",
+			   "the logo has to rasterize to the same cells as CharMatrix would draw them" );
+
+void runScript( const Options& options )
 {
-	static_assert( alloc_strgy == Allocation_Strategy::stack_allocated ||
-				   alloc_strgy == Allocation_Strategy::stack_heap_allocated ||
-				   alloc_strgy == Allocation_Strategy::heap_allocated,
-				   "Unknown allocation strategy" );
-}
+	initialize( );
+
+	if ( options.isLogoDrawn )
+	{
+		logo_figure.draw( std::cout );
+		return;
+	}
+
+	std::optional< util::MappedFile > input_file { };
+	std::optional< util::LineReader > input_reader { };
+
+	if ( options.inputFilePath.empty( ) )
+	{
+		input_reader.emplace( std::cin );
+	}
+	else
+	{
+		// mapping is all the reading a file takes up front, its pages are then read
+		// in place, and faulted in, while the lines are validated
+		const util::ScopedTimer timer { latency::Phase::input };
+
+		input_file.emplace( std::string { options.inputFilePath } );
+		input_reader.emplace( input_file->getContents( ) );
+	}
+
+	const unsigned threadsCount { options.executionMode == Execution_Mode::sequenced ? 1 :
+								  options.threadsCount != 0 ? options.threadsCount :
+								  std::max( std::thread::hardware_concurrency( ), 1U ) };
+
+	if ( options.isAllocationBenchmark )
+	{
+		// every strategy has to see the same input, so standard input is read up front
+		if ( input_file )
+		{
+			benchmark_allocation_strategies( input_file->getContents( ), threadsCount );
+		}
+		else
+		{
+			const std::string inputContents { std::istreambuf_iterator<char>( std::cin ),
+											  std::istreambuf_iterator<char>( ) };
 
+			benchmark_allocation_strategies( inputContents, threadsCount );
+		}
+
+		return;
+	}
+
+	std::optional< RenderCache > render_cache { };
+
+	if ( options.isRenderCached )
+	{
+		render_cache.emplace( options.renderCacheBudget != 0 ? options.renderCacheBudget :
+															  RenderCache::default_memory_budget,
+							  std::filesystem::path { options.renderCacheDirectory } );
+	}
+
+	if ( options.isBatchMode )
+	{
+		if ( options.isPipelined ) { render_pipelined( input_file, threadsCount, render_cache ); }
+		else { render_batch( *input_reader, threadsCount, render_cache ); }
+
+		if ( render_cache ) { report_render_cache_stats( *render_cache ); }
+
+		return;
+	}
+
+	render_document( options.allocationStrategy, *input_reader, threadsCount, std::cout );
 }
 
 template class CharMatrix<>;
-template std::ofstream& operator<<( std::ofstream& ofs, const CharMatrix< std::allocator<char> >& char_matrix );
-template std::ifstream& operator>>( std::ifstream& ifs, CharMatrix< std::allocator<char> >& char_matrix );
+template class CharMatrix< std::allocator<char>, TiledStorage >;
+template class CharMatrix< std::allocator<char>, SparseStorage >;
+template class CharMatrix< std::allocator<char>, StridedStorage >;
+template class CharMatrix< std::allocator<char>, PackedStorage >;
+template class CharMatrix< std::pmr::polymorphic_allocator<char> >;
+template class CharMatrix< std::pmr::polymorphic_allocator<char>, TiledStorage >;
+template class CharMatrix< std::pmr::polymorphic_allocator<char>, SparseStorage >;
+template class CharMatrix< std::pmr::polymorphic_allocator<char>, StridedStorage >;
+template class CharMatrix< std::pmr::polymorphic_allocator<char>, PackedStorage >;
+template std::ofstream& operator<<( std::ofstream& ofs, const CharMatrix< std::allocator<char>, DenseStorage >& char_matrix );
+template std::ifstream& operator>>( std::ifstream& ifs, CharMatrix< std::allocator<char>, DenseStorage >& char_matrix );
+
+// a tiled canvas allocates a tile and a sparse one inserts a cell on the first
+// write to it, so their writes may throw
+static_assert( noexcept( std::declval< CharMatrix<>& >( )[ 0, 0 ] ) );
+static_assert( !noexcept( std::declval< TiledCharMatrix<>& >( )[ 0, 0 ] ) &&
+			   !noexcept( std::declval< TiledCharMatrix<>& >( ).setCharacterMatrix( std::array<uint32_t, 4> { } ) ) );
+static_assert( !noexcept( std::declval< SparseCharMatrix<>& >( )[ 0, 0 ] ) &&
+			   !noexcept( std::declval< SparseCharMatrix<>& >( ).setCharacterMatrix( std::array<uint32_t, 4> { } ) ) );
 
 }
 
@@ -672,16 +1621,28 @@ template std::ifstream& operator>>( std::ifstream& ifs, CharMatrix< std::allocat
 namespace std
 {
 
-template <class Allocator>
-hash< peyknowruzi::CharMatrix<Allocator> >::result_type
-hash< peyknowruzi::CharMatrix<Allocator> >::operator( )( const argument_type& char_matrix ) const
+template < class Allocator, template < class > class Storage >
+hash< peyknowruzi::CharMatrix<Allocator, Storage> >::result_type
+hash< peyknowruzi::CharMatrix<Allocator, Storage> >::operator( )( const argument_type& char_matrix ) const
 {
 	result_type hashValue { 17 };
 	hashValue = 31 * hashValue + std::hash<uint32_t>{ }( char_matrix.getY_AxisLen( ) );
 	hashValue = 31 * hashValue + std::hash<uint32_t>{ }( char_matrix.getX_AxisLen( ) );
 	hashValue = 31 * hashValue + std::hash<char>{ }( char_matrix.getFillCharacter( ) );
+	hashValue = 31 * hashValue + static_cast<result_type>( char_matrix.getContentHash( ) );
 
 	return hashValue;
 }
 
+template struct hash< peyknowruzi::CharMatrix<> >;
+template struct hash< peyknowruzi::TiledCharMatrix<> >;
+template struct hash< peyknowruzi::SparseCharMatrix<> >;
+template struct hash< peyknowruzi::StridedCharMatrix<> >;
+template struct hash< peyknowruzi::PackedCharMatrix<> >;
+template struct hash< peyknowruzi::pmr::CharMatrix >;
+template struct hash< peyknowruzi::pmr::TiledCharMatrix >;
+template struct hash< peyknowruzi::pmr::SparseCharMatrix >;
+template struct hash< peyknowruzi::pmr::StridedCharMatrix >;
+template struct hash< peyknowruzi::pmr::PackedCharMatrix >;
+
 }
@@ -25,22 +25,47 @@
 #pragma once
 
 #include "pch.hpp"
+#include "Storage.hpp"
+#include "Options.hpp"
 
 
 namespace peyknowruzi
 {
 
+namespace util
+{
+	class LineReader;
+}
+
 inline constexpr std::streamsize default_buffer_size { 169 };
 
-template < class Allocator = std::allocator<char> >
+template < class Allocator = std::allocator<char>,
+		   template < class > class Storage = DenseStorage >
 class CharMatrix
 {
 public:
+	using storage_type = Storage<Allocator>;
+
+	static constexpr std::uint32_t min_allowed_y_axis_len { storage_type::min_y_axis_len };
+	static constexpr std::uint32_t min_allowed_x_axis_len { storage_type::min_x_axis_len };
+	static constexpr std::uint32_t max_allowed_y_axis_len { storage_type::max_y_axis_len };
+	static constexpr std::uint32_t max_allowed_x_axis_len { storage_type::max_x_axis_len };
 	static constexpr std::uint32_t default_y_axis_len { 20 };
 	static constexpr std::uint32_t default_x_axis_len { 20 };
 	static constexpr char default_fill_character { ' ' };
 	static constexpr std::size_t cartesian_components_count { 4 };
 	static constexpr std::size_t matrix_attributes_count { 3 };
+	static constexpr std::size_t min_coords_per_row_band { 1024 };
+
+	// the columns [ first, last ] of a row changed since the last draw,
+	// first > last means the row is unchanged
+	struct RowSpan
+	{
+		std::uint32_t first;
+		std::uint32_t last;
+	};
+
+	static constexpr RowSpan clean_row_span { std::numeric_limits<std::uint32_t>::max( ), 0 };
 
 private:
 	enum AllowedChars : char
@@ -56,6 +81,13 @@ private:
 																			   ForwardSlash,
 																			   VerticalSlash };
 
+	// indexed by ( x2 - x1 + 1 ) * 4 + ( y2 - y1 + 1 ) with both terms clamped to 3,
+	// '\0' marks a pair of coordinates that can not be drawn
+	static constexpr std::array<char, 16> char_type_table { BackSlash	 , Dash, ForwardSlash , '\0',
+															VerticalSlash, '\0', VerticalSlash, '\0',
+															ForwardSlash , Dash, BackSlash	 , '\0',
+															'\0'		 , '\0', '\0'		 , '\0' };
+
 public:
 	explicit CharMatrix( const std::uint32_t Y_AxisLen = default_y_axis_len,
 						 const std::uint32_t X_AxisLen = default_x_axis_len,
@@ -67,19 +99,35 @@ public:
 	explicit operator bool( ) const noexcept;
 	bool operator==( const CharMatrix& rhs ) const noexcept;
 	std::partial_ordering operator<=>( const CharMatrix& rhs ) const noexcept;
-	char& operator[ ]( const std::size_t X_Axis, const std::size_t Y_Axis ) noexcept;
-	const char& operator[ ]( const std::size_t X_Axis, const std::size_t Y_Axis ) const noexcept;
+	typename storage_type::reference
+	operator[ ]( const std::size_t X_Axis, const std::size_t Y_Axis ) noexcept( storage_type::is_nothrow_access );
+	typename storage_type::const_reference
+	operator[ ]( const std::size_t X_Axis, const std::size_t Y_Axis ) const noexcept;
 
 	[[ nodiscard ]] const std::uint32_t& getY_AxisLen( ) const noexcept;
 	[[ nodiscard ]] const std::uint32_t& getX_AxisLen( ) const noexcept;
 	[[ nodiscard ]] const char& getFillCharacter( ) const noexcept;
-	[[ nodiscard ]] const std::vector<char, Allocator>& getCharacterMatrix( ) const noexcept;
+	[[ nodiscard ]] const std::vector<char, Allocator>& getCharacterMatrix( ) const noexcept
+	requires std::same_as< storage_type, DenseStorage<Allocator> >;
+	[[ nodiscard ]] const storage_type& getStorage( ) const noexcept;
+	[[ nodiscard ]] RowSpan getDirtyRowSpan( const std::uint32_t Y_Axis ) const noexcept;
+	[[ nodiscard ]] std::uint64_t getContentHash( ) const noexcept;
+	// for every row the columns where the cells of rhs differ from this matrix,
+	// clean_row_span where they are all equal
+	[[ nodiscard ]] std::vector<RowSpan> diff( const CharMatrix& rhs ) const;
+	[[ nodiscard ]] static constexpr std::size_t
+	getRequiredBufferSize( const std::uint32_t Y_AxisLen, const std::uint32_t X_AxisLen ) noexcept
+	requires std::same_as< storage_type, DenseStorage<Allocator> >;
 
 	void setY_AxisLen( const std::uint32_t Y_AxisLen );
 	void setX_AxisLen( const std::uint32_t X_AxisLen );
 	void setFillCharacter( const char fillCharacter );
 	void setCharacterMatrix( const std::array<std::uint32_t, cartesian_components_count>&
-							 coordsOfChar ) noexcept;
+							 coordsOfChar ) noexcept( storage_type::is_nothrow_access );
+	void setCharacterMatrix( const std::span< const std::array<std::uint32_t, cartesian_components_count> >
+							 coordsOfChars ) noexcept( storage_type::is_nothrow_access );
+	void setCharacterMatrixInRowBands( const std::span< const std::array<std::uint32_t, cartesian_components_count> >
+									   coordsOfChars, const unsigned threadsCount );
 
 	[[ nodiscard ]] bool
 	validateEnteredCoords( const std::string_view str_enteredCoords,
@@ -95,41 +143,110 @@ public:
 	processCoordsToObtainCharType( const std::array<std::uint32_t, cartesian_components_count>&
 								   coordsOfChar ) noexcept;
 
-	[[ nodiscard ]] std::size_t getNumOfInputLines( ) const;
-	[[ nodiscard ]] static auto getMatrixAttributes( );
-	void getCoords( );
+	[[ nodiscard ]] static constexpr char
+	lookupCharType( const std::array<std::uint32_t, cartesian_components_count>& coordsOfChar ) noexcept;
+
+	[[ nodiscard ]] std::size_t getNumOfInputLines( util::LineReader& input_reader ) const;
+	[[ nodiscard ]] static auto getMatrixAttributes( util::LineReader& input_reader );
+	[[ nodiscard ]] static std::optional< std::tuple<std::uint32_t, std::uint32_t, char> >
+	tryGetMatrixAttributes( util::LineReader& input_reader );
+	void getCoords( util::LineReader& input_reader, const unsigned threadsCount = 1 );
+	void getCoords( util::LineReader& input_reader,
+					std::vector< std::array<std::uint32_t, cartesian_components_count> >& coordsOfChars_OUT ) const;
 	void draw( std::ostream& output_stream ) const;
+	void drawChanges( std::ostream& output_stream ) const;
 
 	template <class Alloc>
-	friend std::ofstream& operator<<( std::ofstream& ofs, const CharMatrix<Alloc>& char_matrix );
+	friend std::ofstream& operator<<( std::ofstream& ofs, const CharMatrix<Alloc, DenseStorage>& char_matrix );
 	template <class Alloc>
-	friend std::ifstream& operator>>( std::ifstream& ifs, CharMatrix<Alloc>& char_matrix );
+	friend std::ifstream& operator>>( std::ifstream& ifs, CharMatrix<Alloc, DenseStorage>& char_matrix );
 
 private:
+	using row_spans_type = std::vector< RowSpan,
+										typename std::allocator_traits<Allocator>::template rebind_alloc<RowSpan> >;
+
+	[[ nodiscard ]] std::strong_ordering compareCells( const CharMatrix& rhs ) const noexcept;
+	[[ nodiscard ]] RowSpan diffRow( const CharMatrix& rhs, const std::uint32_t Y_Axis ) const noexcept;
+	[[ nodiscard ]] std::uint64_t writeCell( const std::uint32_t X_Axis, const std::uint32_t Y_Axis,
+											 const char ch, std::uint64_t& cellsOverwrittenCount_OUT )
+											 noexcept( storage_type::is_nothrow_access );
+	void markDirty( const std::uint32_t X_Axis, const std::uint32_t Y_Axis ) noexcept;
+	void markAllRowsDirty( ) noexcept;
+	void markAllRowsClean( ) const noexcept;
+
 	std::uint32_t m_Y_AxisLen;
 	std::uint32_t m_X_AxisLen;
 	char m_fillCharacter;
-	std::vector<char, Allocator> m_characterMatrix;
+	storage_type m_storage;
+	// one span per row, allocated by the first drawChanges( ) so that a canvas
+	// that is only ever drawn whole pays nothing per row; until then any change
+	// marks every row dirty
+	mutable row_spans_type m_dirtyRowSpans;
+	mutable bool m_areAllRowsDirty;
+	// the wrapping sum of util::mix_cell over the cells that do not hold the
+	// fill character, kept up to date by setCharacterMatrix and recomputed on
+	// demand after anything else that may change the cells
+	mutable std::uint64_t m_contentHash;
+	mutable bool m_isContentHashValid;
 };
 
+template < class Allocator, template < class > class Storage >
+[[ nodiscard ]] inline constexpr std::size_t
+CharMatrix<Allocator, Storage>::getRequiredBufferSize( const std::uint32_t Y_AxisLen,
+													   const std::uint32_t X_AxisLen ) noexcept
+requires std::same_as< storage_type, DenseStorage<Allocator> >
+{
+	return std::size_t { Y_AxisLen } * X_AxisLen + std::size_t { Y_AxisLen } * sizeof( RowSpan ) + 500;
+}
+
+template < class Allocator, template < class > class Storage >
+[[ nodiscard ]] inline constexpr char
+CharMatrix<Allocator, Storage>::lookupCharType( const std::array<std::uint32_t, cartesian_components_count>&
+												coordsOfChar ) noexcept
+{
+	const auto& [ x1, y1, x2, y2 ] { coordsOfChar };
+
+	// a difference other than -1, 0 or 1 wraps around or exceeds 2 and lands on index 3
+	const std::uint64_t dx_idx { std::min<std::uint64_t>( std::uint64_t { x2 } - x1 + 1, 3 ) };
+	const std::uint64_t dy_idx { std::min<std::uint64_t>( std::uint64_t { y2 } - y1 + 1, 3 ) };
+
+	return char_type_table[ dx_idx * 4 + dy_idx ];
+}
+
+template < class Allocator = std::allocator<char> >
+using TiledCharMatrix = CharMatrix< Allocator, TiledStorage >;
+
+template < class Allocator = std::allocator<char> >
+using SparseCharMatrix = CharMatrix< Allocator, SparseStorage >;
+
+template < class Allocator = std::allocator<char> >
+using StridedCharMatrix = CharMatrix< Allocator, StridedStorage >;
+
+template < class Allocator = std::allocator<char> >
+using PackedCharMatrix = CharMatrix< Allocator, PackedStorage >;
+
 namespace pmr
 {
 	using CharMatrix = peyknowruzi::CharMatrix< std::pmr::polymorphic_allocator<char> >;
+	using TiledCharMatrix = peyknowruzi::TiledCharMatrix< std::pmr::polymorphic_allocator<char> >;
+	using SparseCharMatrix = peyknowruzi::SparseCharMatrix< std::pmr::polymorphic_allocator<char> >;
+	using StridedCharMatrix = peyknowruzi::StridedCharMatrix< std::pmr::polymorphic_allocator<char> >;
+	using PackedCharMatrix = peyknowruzi::PackedCharMatrix< std::pmr::polymorphic_allocator<char> >;
 }
 
 
 void initialize( );
-void runScript( );
+void runScript( const Options& options );
 
 }
 
 namespace std
 {
 
-template <class Allocator>
-struct hash< peyknowruzi::CharMatrix<Allocator> >
+template < class Allocator, template < class > class Storage >
+struct hash< peyknowruzi::CharMatrix<Allocator, Storage> >
 {
-	using argument_type = peyknowruzi::CharMatrix<Allocator>;
+	using argument_type = peyknowruzi::CharMatrix<Allocator, Storage>;
 	using result_type = std::size_t;
 
 	result_type operator( )( const argument_type& char_matrix ) const;
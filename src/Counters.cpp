@@ -0,0 +1,58 @@
+
+// PeykNowruzi - Basic ASCII-Art Generator
+// Copyright (C) 2021-2022 Kasra Hashemi
+
+/*
+
+ This file is part of PeykNowruzi.
+
+ PeykNowruzi is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License,
+ or (at your option) any later version.
+
+ PeykNowruzi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty
+ of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with PeykNowruzi. If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "Counters.hpp"
+#include "Util.hpp"
+#include "pch.hpp"
+
+
+namespace peyknowruzi::counters
+{
+
+static constinit util::ExitReport exit_report { "Counters_Exception" };
+
+void enable_report( const std::string_view outputFilePath ) noexcept
+{
+	exit_report.enable( outputFilePath );
+}
+
+void write_report( )
+{
+	if ( !exit_report.isEnabled( ) ) { return; }
+
+	std::ostringstream report;
+	report << "{\n";
+
+	for ( std::size_t idx { }; idx < counters_count; ++idx )
+	{
+		report << "  \"" << counter_names[ idx ] << "\": " << get( static_cast<Counter>( idx ) )
+			   << ( idx + 1 < counters_count ? ",\n" : "\n" );
+	}
+
+	report << "}\n";
+
+	exit_report.write( report.view( ) );
+}
+
+}
@@ -0,0 +1,99 @@
+
+// PeykNowruzi - Basic ASCII-Art Generator
+// Copyright (C) 2021-2022 Kasra Hashemi
+
+/*
+
+ This file is part of PeykNowruzi.
+
+ PeykNowruzi is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License,
+ or (at your option) any later version.
+
+ PeykNowruzi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty
+ of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with PeykNowruzi. If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+
+#pragma once
+
+#include "pch.hpp"
+
+
+namespace peyknowruzi::counters
+{
+
+// Always compiled in, unlike log( ). Hot loops count into a ScopedCount on
+// their own stack and only touch the shared counters once per call, so
+// counting costs a relaxed atomic add per batch rather than per line or cell.
+enum class Counter : std::size_t
+{
+	lines_read,
+	coords_lines_rejected, // by validateEnteredCoords
+	input_retries, // lines read again because the previous one was rejected
+	cells_written,
+	cells_overwritten, // written over a cell that already held a character
+	bytes_drawn, // by draw( ), a drawing the render cache hands out again is not drawn
+};
+
+inline constexpr std::size_t counters_count { std::to_underlying( Counter::bytes_drawn ) + 1 };
+
+inline constexpr std::array<std::string_view, counters_count> counter_names
+{
+	"lines_read",
+	"coords_lines_rejected",
+	"input_retries",
+	"cells_written",
+	"cells_overwritten",
+	"bytes_drawn",
+};
+
+namespace detail
+{
+	inline constinit std::array< std::atomic<std::uint64_t>, counters_count > values { };
+}
+
+inline void add( const Counter counter, const std::uint64_t count ) noexcept
+{
+	if ( count != 0 )
+	{
+		detail::values[ std::to_underlying( counter ) ].fetch_add( count, std::memory_order_relaxed );
+	}
+}
+
+[[ nodiscard ]] inline std::uint64_t get( const Counter counter ) noexcept
+{
+	return detail::values[ std::to_underlying( counter ) ].load( std::memory_order_relaxed );
+}
+
+class ScopedCount
+{
+public:
+	explicit ScopedCount( const Counter counter ) noexcept : m_counter( counter ), m_count( 0 ) { }
+	~ScopedCount( ) { add( m_counter, m_count ); }
+	ScopedCount( const ScopedCount& ) = delete;
+	ScopedCount& operator=( const ScopedCount& ) = delete;
+
+	ScopedCount& operator+=( const std::uint64_t count ) noexcept { m_count += count; return *this; }
+	ScopedCount& operator++( ) noexcept { ++m_count; return *this; }
+
+private:
+	Counter m_counter;
+	std::uint64_t m_count;
+};
+
+// has write_report( ) write the counters where util::ExitReport::enable( ) says
+void enable_report( const std::string_view outputFilePath ) noexcept;
+
+// writes the counters as a JSON object if enable_report( ) was called, meant to
+// run once at exit
+void write_report( );
+
+}
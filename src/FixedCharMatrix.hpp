@@ -0,0 +1,206 @@
+
+// PeykNowruzi - Basic ASCII-Art Generator
+// Copyright (C) 2021-2022 Kasra Hashemi
+
+/*
+
+ This file is part of PeykNowruzi.
+
+ PeykNowruzi is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License,
+ or (at your option) any later version.
+
+ PeykNowruzi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty
+ of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with PeykNowruzi. If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+
+#pragma once
+
+#include "pch.hpp"
+#include "CharMatrix.hpp"
+#include "Util.hpp"
+
+
+namespace peyknowruzi
+{
+
+// A canvas whose dimensions and fill character are template arguments. Its
+// cells live in a std::array laid out like DenseStorage, newline column
+// included, and everything but draw( ) is constexpr, so a figure that is known
+// while compiling can be rasterized then and kept as a static string.
+template < std::uint32_t Y_AxisLen, std::uint32_t X_AxisLen,
+		   char FillCharacter = CharMatrix<>::default_fill_character >
+class FixedCharMatrix
+{
+public:
+	static_assert( Y_AxisLen >= CharMatrix<>::min_allowed_y_axis_len && Y_AxisLen <= CharMatrix<>::max_allowed_y_axis_len,
+				   "Y_AxisLen can not be greater than max_allowed_y_axis_len or "
+				   "less than min_allowed_y_axis_len" );
+
+	static_assert( X_AxisLen >= CharMatrix<>::min_allowed_x_axis_len && X_AxisLen <= CharMatrix<>::max_allowed_x_axis_len,
+				   "X_AxisLen can not be greater than max_allowed_x_axis_len or "
+				   "less than min_allowed_x_axis_len" );
+
+	static_assert( std::string_view { "-\\/|" }.find( FillCharacter ) == std::string_view::npos,
+				   "FillCharacter can not be one of the characters lines are drawn with" );
+
+	static constexpr std::size_t cartesian_components_count { CharMatrix<>::cartesian_components_count };
+
+	using coords_type = std::array<std::uint32_t, cartesian_components_count>;
+
+	static constexpr coords_type max_allowed_coords { X_AxisLen - 2, Y_AxisLen - 1, X_AxisLen - 2, Y_AxisLen - 1 };
+
+	constexpr FixedCharMatrix( ) noexcept;
+
+	[[ nodiscard ]] constexpr char& operator[ ]( const std::size_t X_Axis, const std::size_t Y_Axis ) noexcept;
+	[[ nodiscard ]] constexpr const char& operator[ ]( const std::size_t X_Axis, const std::size_t Y_Axis ) const noexcept;
+
+	[[ nodiscard ]] static constexpr std::uint32_t getY_AxisLen( ) noexcept { return Y_AxisLen; }
+	[[ nodiscard ]] static constexpr std::uint32_t getX_AxisLen( ) noexcept { return X_AxisLen; }
+	[[ nodiscard ]] static constexpr char getFillCharacter( ) noexcept { return FillCharacter; }
+	[[ nodiscard ]] constexpr std::string_view getCharacterMatrix( ) const noexcept;
+
+	constexpr void setCharacterMatrix( const coords_type& coordsOfChar ) noexcept;
+	constexpr void setCharacterMatrix( const std::span<const coords_type> coordsOfChars ) noexcept;
+
+	[[ nodiscard ]] static constexpr bool
+	validateEnteredCoords( const std::string_view str_enteredCoords, coords_type& int_enteredCoords_OUT ) noexcept;
+
+	void draw( std::ostream& output_stream ) const;
+
+private:
+	std::array<char, std::size_t { Y_AxisLen } * X_AxisLen> m_characterMatrix;
+};
+
+// rasterizes a figure given as lines of coordinates while compiling; a line that
+// validateEnteredCoords rejects stops the compilation
+template < std::uint32_t Y_AxisLen, std::uint32_t X_AxisLen,
+		   char FillCharacter = CharMatrix<>::default_fill_character >
+[[ nodiscard ]] consteval FixedCharMatrix<Y_AxisLen, X_AxisLen, FillCharacter>
+render_fixed_figure( std::string_view coordsLines )
+{
+	using char_matrix_type = FixedCharMatrix<Y_AxisLen, X_AxisLen, FillCharacter>;
+
+	char_matrix_type matrix;
+
+	while ( !coordsLines.empty( ) )
+	{
+		const std::size_t lineLen { std::min( coordsLines.find( '\n' ), coordsLines.size( ) ) };
+		const std::string_view line { coordsLines.substr( 0, lineLen ) };
+		coordsLines.remove_prefix( std::min( lineLen + 1, coordsLines.size( ) ) );
+
+		if ( line.find_first_not_of( " \t" ) == std::string_view::npos ) { continue; }
+
+		typename char_matrix_type::coords_type coordsOfChar;
+
+		if ( !char_matrix_type::validateEnteredCoords( line, coordsOfChar ) )
+		{
+			throw std::invalid_argument( "Invalid_Coords_Exception: A line of the figure holds invalid coordinates" );
+		}
+
+		matrix.setCharacterMatrix( coordsOfChar );
+	}
+
+	return matrix;
+}
+
+
+template < std::uint32_t Y_AxisLen, std::uint32_t X_AxisLen, char FillCharacter >
+inline constexpr FixedCharMatrix<Y_AxisLen, X_AxisLen, FillCharacter>::FixedCharMatrix( ) noexcept
+
+	: m_characterMatrix( )
+{
+	m_characterMatrix.fill( FillCharacter );
+
+	for ( std::size_t last_idx_of_row { X_AxisLen - 1 }; last_idx_of_row < m_characterMatrix.size( )
+		  ; last_idx_of_row += X_AxisLen )
+	{
+		m_characterMatrix[ last_idx_of_row ] = '\n';
+	}
+}
+
+template < std::uint32_t Y_AxisLen, std::uint32_t X_AxisLen, char FillCharacter >
+[[ nodiscard ]] inline constexpr char&
+FixedCharMatrix<Y_AxisLen, X_AxisLen, FillCharacter>::operator[ ]( const std::size_t X_Axis,
+																   const std::size_t Y_Axis ) noexcept
+{
+	return m_characterMatrix[ Y_Axis * X_AxisLen + X_Axis ];
+}
+
+template < std::uint32_t Y_AxisLen, std::uint32_t X_AxisLen, char FillCharacter >
+[[ nodiscard ]] inline constexpr const char&
+FixedCharMatrix<Y_AxisLen, X_AxisLen, FillCharacter>::operator[ ]( const std::size_t X_Axis,
+																   const std::size_t Y_Axis ) const noexcept
+{
+	return m_characterMatrix[ Y_Axis * X_AxisLen + X_Axis ];
+}
+
+template < std::uint32_t Y_AxisLen, std::uint32_t X_AxisLen, char FillCharacter >
+[[ nodiscard ]] inline constexpr std::string_view
+FixedCharMatrix<Y_AxisLen, X_AxisLen, FillCharacter>::getCharacterMatrix( ) const noexcept
+{
+	return { m_characterMatrix.data( ), m_characterMatrix.size( ) };
+}
+
+template < std::uint32_t Y_AxisLen, std::uint32_t X_AxisLen, char FillCharacter >
+inline constexpr void
+FixedCharMatrix<Y_AxisLen, X_AxisLen, FillCharacter>::setCharacterMatrix( const coords_type& coordsOfChar ) noexcept
+{
+	const char ch { CharMatrix<>::lookupCharType( coordsOfChar ) };
+
+	if ( const auto& [ x1, y1, x2, y2 ] { coordsOfChar }; ch != '\0' )
+	{
+		( *this )[ x1, y1 ] = ch;
+		( *this )[ x2, y2 ] = ch;
+	}
+}
+
+template < std::uint32_t Y_AxisLen, std::uint32_t X_AxisLen, char FillCharacter >
+inline constexpr void
+FixedCharMatrix<Y_AxisLen, X_AxisLen, FillCharacter>::setCharacterMatrix( const std::span<const coords_type>
+																		  coordsOfChars ) noexcept
+{
+	for ( const coords_type& coordsOfChar : coordsOfChars )
+	{
+		setCharacterMatrix( coordsOfChar );
+	}
+}
+
+template < std::uint32_t Y_AxisLen, std::uint32_t X_AxisLen, char FillCharacter >
+[[ nodiscard ]] inline constexpr bool
+FixedCharMatrix<Y_AxisLen, X_AxisLen, FillCharacter>::validateEnteredCoords( const std::string_view str_enteredCoords,
+																			 coords_type& int_enteredCoords_OUT ) noexcept
+{
+	if consteval
+	{
+		return util::parse_uint32_quad_serially( str_enteredCoords, int_enteredCoords_OUT, max_allowed_coords );
+	}
+	else
+	{
+		return util::parse_uint32_quad( str_enteredCoords, int_enteredCoords_OUT, max_allowed_coords );
+	}
+}
+
+template < std::uint32_t Y_AxisLen, std::uint32_t X_AxisLen, char FillCharacter >
+void FixedCharMatrix<Y_AxisLen, X_AxisLen, FillCharacter>::draw( std::ostream& output_stream ) const
+{
+	if ( std::optional< util::FdOutput > output { util::FdOutput::for_stream( output_stream ) } )
+	{
+		output->append( getCharacterMatrix( ) );
+		output->flush( );
+	}
+	else
+	{
+		output_stream.write( m_characterMatrix.data( ), static_cast<std::streamsize>( m_characterMatrix.size( ) ) );
+	}
+}
+
+}
@@ -0,0 +1,100 @@
+
+// PeykNowruzi - Basic ASCII-Art Generator
+// Copyright (C) 2021-2022 Kasra Hashemi
+
+/*
+
+ This file is part of PeykNowruzi.
+
+ PeykNowruzi is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License,
+ or (at your option) any later version.
+
+ PeykNowruzi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty
+ of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with PeykNowruzi. If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+
+// Writes a synthetic stream of documents in the format of --batch to the
+// standard output, e.g.
+//   PeykNowruziGen --documents=10000 --density=0.2 --invalid-ratio=0.05 --seed=7 > input.txt
+// and with --expected=PATH also what drawing the stream has to print.
+
+
+#include "Workload.hpp"
+#include "pch.hpp"
+
+
+namespace pnw = peyknowruzi::workload;
+
+
+int main( int argc, char* argv[] )
+{
+	using std::string_view_literals::operator""sv;
+
+	static constexpr std::string_view expected_option_prefix { "--expected="sv };
+
+	const std::span<char* const> args { argv, static_cast<std::size_t>( argc ) };
+
+	try
+	{
+		pnw::WorkloadSettings settings { };
+		std::string_view expectedOutputPath { };
+
+		for ( const std::string_view arg : args.subspan( std::min<std::size_t>( args.size( ), 1 ) ) )
+		{
+			if ( pnw::parse_workload_option( arg, settings ) ) { continue; }
+
+			if ( arg.starts_with( expected_option_prefix ) )
+			{
+				expectedOutputPath = arg.substr( expected_option_prefix.size( ) );
+			}
+			else
+			{
+				throw std::runtime_error( "Invalid_Option_Exception: Unknown option '" + std::string { arg } + "'" );
+			}
+		}
+
+		std::string input;
+		std::string expectedOutput;
+
+		const pnw::WorkloadStats stats { pnw::generate_workload( settings, input, expectedOutputPath.empty( ) ?
+																 nullptr : &expectedOutput ) };
+
+		std::cout.write( input.data( ), static_cast<std::streamsize>( input.size( ) ) ).flush( );
+
+		if ( !expectedOutputPath.empty( ) )
+		{
+			std::ofstream ofs { std::string { expectedOutputPath }, std::ios_base::binary | std::ios_base::trunc };
+			ofs.write( expectedOutput.data( ), static_cast<std::streamsize>( expectedOutput.size( ) ) );
+
+			if ( !ofs.flush( ) )
+			{
+				throw std::runtime_error( "Output_File_Exception: Could not write '" +
+										  std::string { expectedOutputPath } + "'" );
+			}
+		}
+
+		std::cerr << stats.documentsCount << " documents, " << stats.linesCount << " lines of which "
+				  << stats.invalidLinesCount << " invalid, " << input.size( ) << " bytes\n";
+	}
+	catch ( const std::bad_alloc& )
+	{
+		std::cerr << "Memory_Exception: Ran out of memory\n";
+		return EXIT_FAILURE;
+	}
+	catch ( const std::exception& ex )
+	{
+		std::cerr << ex.what( ) << '\n';
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,161 @@
+
+// PeykNowruzi - Basic ASCII-Art Generator
+// Copyright (C) 2021-2022 Kasra Hashemi
+
+/*
+
+ This file is part of PeykNowruzi.
+
+ PeykNowruzi is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License,
+ or (at your option) any later version.
+
+ PeykNowruzi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty
+ of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with PeykNowruzi. If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "Latency.hpp"
+#include "Util.hpp"
+#include "pch.hpp"
+
+
+namespace peyknowruzi::latency
+{
+
+void LatencyHistogram::record( const std::uint64_t value ) noexcept
+{
+	const std::size_t bucketIdx { getBucketIdx( value ) };
+
+	++m_counts[ bucketIdx ];
+	++m_count;
+	m_min = std::min( m_min, value );
+	m_max = std::max( m_max, value );
+	m_lowestBucketIdx = std::min( m_lowestBucketIdx, bucketIdx );
+	m_highestBucketIdx = std::max( m_highestBucketIdx, bucketIdx );
+}
+
+void LatencyHistogram::merge( const LatencyHistogram& other ) noexcept
+{
+	if ( other.m_count == 0 ) { return; }
+
+	for ( std::size_t bucketIdx { other.m_lowestBucketIdx }; bucketIdx <= other.m_highestBucketIdx; ++bucketIdx )
+	{
+		m_counts[ bucketIdx ] += other.m_counts[ bucketIdx ];
+	}
+
+	m_count += other.m_count;
+	m_min = std::min( m_min, other.m_min );
+	m_max = std::max( m_max, other.m_max );
+	m_lowestBucketIdx = std::min( m_lowestBucketIdx, other.m_lowestBucketIdx );
+	m_highestBucketIdx = std::max( m_highestBucketIdx, other.m_highestBucketIdx );
+}
+
+[[ nodiscard ]] std::uint64_t LatencyHistogram::getCount( ) const noexcept
+{
+	return m_count;
+}
+
+[[ nodiscard ]] std::uint64_t LatencyHistogram::getMin( ) const noexcept
+{
+	return m_count == 0 ? 0 : m_min;
+}
+
+[[ nodiscard ]] std::uint64_t LatencyHistogram::getMax( ) const noexcept
+{
+	return m_max;
+}
+
+[[ nodiscard ]] std::uint64_t LatencyHistogram::getValueAtPercentile( const double percentile ) const noexcept
+{
+	if ( m_count == 0 ) { return 0; }
+
+	// nearest rank, the first bucket whose running count reaches it
+	const double rank { std::ceil( std::clamp( percentile, 0.0, 100.0 ) / 100.0 * static_cast<double>( m_count ) ) };
+	const std::uint64_t targetCount { std::max<std::uint64_t>( static_cast<std::uint64_t>( rank ), 1 ) };
+
+	std::uint64_t runningCount { };
+
+	for ( std::size_t bucketIdx { m_lowestBucketIdx }; bucketIdx <= m_highestBucketIdx; ++bucketIdx )
+	{
+		runningCount += m_counts[ bucketIdx ];
+
+		if ( runningCount >= targetCount ) { return std::min( getBucketUpperBound( bucketIdx ), m_max ); }
+	}
+
+	return m_max;
+}
+
+// constant initialized, so that they are still alive when the last threads
+// exit and write_report( ) runs from an atexit handler
+static constinit std::mutex merged_histograms_mutex { };
+static constinit std::array<LatencyHistogram, phases_count> merged_histograms { };
+static constinit util::ExitReport exit_report { "Latency_Exception" };
+
+// only the owning thread ever writes to these, which keeps recording free of
+// locks and atomics; the lock is taken once, when the thread exits
+struct ThreadHistograms
+{
+	std::array<LatencyHistogram, phases_count> histograms { };
+
+	~ThreadHistograms( )
+	{
+		const std::scoped_lock lock { merged_histograms_mutex };
+
+		for ( std::size_t idx { }; idx < phases_count; ++idx )
+		{
+			merged_histograms[ idx ].merge( histograms[ idx ] );
+		}
+	}
+};
+
+static thread_local ThreadHistograms thread_histograms { };
+
+void record( const Phase phase, const std::chrono::nanoseconds duration ) noexcept
+{
+	thread_histograms.histograms[ std::to_underlying( phase ) ].record(
+		static_cast<std::uint64_t>( std::max( duration.count( ), std::chrono::nanoseconds::rep { } ) ) );
+}
+
+void enable_report( const std::string_view outputFilePath ) noexcept
+{
+	exit_report.enable( outputFilePath );
+}
+
+void write_report( )
+{
+	if ( !exit_report.isEnabled( ) ) { return; }
+
+	std::ostringstream report;
+	report << "{\n";
+
+	{
+		const std::scoped_lock lock { merged_histograms_mutex };
+
+		for ( std::size_t idx { }; idx < phases_count; ++idx )
+		{
+			const LatencyHistogram& histogram { merged_histograms[ idx ] };
+
+			report << "  \"" << phase_names[ idx ] << "\": { \"count\": " << histogram.getCount( )
+				   << ", \"min_ns\": " << histogram.getMin( )
+				   << ", \"p50_ns\": " << histogram.getValueAtPercentile( 50.0 )
+				   << ", \"p99_ns\": " << histogram.getValueAtPercentile( 99.0 )
+				   << ", \"p999_ns\": " << histogram.getValueAtPercentile( 99.9 )
+				   << ", \"max_ns\": " << histogram.getMax( ) << " }"
+				   << ( idx + 1 < phases_count ? ",\n" : "\n" );
+		}
+	}
+
+	report << "}\n";
+
+	exit_report.write( report.view( ) );
+}
+
+}
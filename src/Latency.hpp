@@ -0,0 +1,125 @@
+
+// PeykNowruzi - Basic ASCII-Art Generator
+// Copyright (C) 2021-2022 Kasra Hashemi
+
+/*
+
+ This file is part of PeykNowruzi.
+
+ PeykNowruzi is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License,
+ or (at your option) any later version.
+
+ PeykNowruzi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty
+ of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with PeykNowruzi. If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+
+#pragma once
+
+#include "pch.hpp"
+
+
+namespace peyknowruzi::latency
+{
+
+enum class Phase : std::size_t
+{
+	input, // a block of input read by LineReader, an input file mapped or a block of it paged in
+	validate, // coordinate lines tokenized and validated, per batch of them
+	rasterize, // a batch of coordinates drawn onto the canvas
+	draw, // a canvas written out
+	serialize, // a canvas saved to or loaded from a file
+};
+
+inline constexpr std::size_t phases_count { std::to_underlying( Phase::serialize ) + 1 };
+
+inline constexpr std::array<std::string_view, phases_count> phase_names
+{
+	"input",
+	"validate",
+	"rasterize",
+	"draw",
+	"serialize",
+};
+
+// A histogram in the manner of HdrHistogram: each power of two is split into
+// 32 linear sub-buckets, so a recorded value is known to within about 3 % from
+// one nanosecond up to 2^40 ns, about 18 minutes; longer ones are clamped.
+class LatencyHistogram
+{
+public:
+	static constexpr unsigned sub_bucket_bits { 5 };
+	static constexpr unsigned max_value_bits { 40 };
+	static constexpr std::size_t sub_buckets_count { std::size_t { 1 } << sub_bucket_bits };
+	static constexpr std::size_t buckets_count { ( max_value_bits - sub_bucket_bits + 1 ) * sub_buckets_count };
+	static constexpr std::uint64_t max_trackable_value { ( std::uint64_t { 1 } << max_value_bits ) - 1 };
+
+	constexpr LatencyHistogram( ) noexcept = default;
+
+	void record( const std::uint64_t value ) noexcept;
+	void merge( const LatencyHistogram& other ) noexcept;
+
+	[[ nodiscard ]] std::uint64_t getCount( ) const noexcept;
+	[[ nodiscard ]] std::uint64_t getMin( ) const noexcept;
+	[[ nodiscard ]] std::uint64_t getMax( ) const noexcept;
+	// the highest value that counts as equal to the one at percentile, clamped to
+	// the largest value recorded; 0 while the histogram is empty
+	[[ nodiscard ]] std::uint64_t getValueAtPercentile( const double percentile ) const noexcept;
+
+	[[ nodiscard ]] static constexpr std::size_t getBucketIdx( const std::uint64_t value ) noexcept;
+	[[ nodiscard ]] static constexpr std::uint64_t getBucketUpperBound( const std::size_t bucketIdx ) noexcept;
+
+private:
+	std::array<std::uint64_t, buckets_count> m_counts { };
+	std::uint64_t m_count { };
+	std::uint64_t m_min { std::numeric_limits<std::uint64_t>::max( ) };
+	std::uint64_t m_max { };
+	std::size_t m_lowestBucketIdx { buckets_count }; // only the buckets in between are walked
+	std::size_t m_highestBucketIdx { };
+};
+
+// adds duration to the calling thread's histogram of phase; the histograms of a
+// thread are merged into the process wide ones when the thread exits
+void record( const Phase phase, const std::chrono::nanoseconds duration ) noexcept;
+
+// has write_report( ) write the merged histograms where util::ExitReport::enable( ) says
+void enable_report( const std::string_view outputFilePath ) noexcept;
+
+// writes count, min, p50, p99, p999 and max of every phase as a JSON object if
+// enable_report( ) was called, meant to run once at exit
+void write_report( );
+
+
+[[ nodiscard ]] inline constexpr std::size_t
+LatencyHistogram::getBucketIdx( const std::uint64_t value ) noexcept
+{
+	const std::uint64_t clampedValue { std::min( value, max_trackable_value ) };
+
+	if ( clampedValue < 2 * sub_buckets_count ) { return static_cast<std::size_t>( clampedValue ); }
+
+	// the top sub_bucket_bits + 1 bits of the value pick the bucket
+	const unsigned shift { static_cast<unsigned>( std::bit_width( clampedValue ) ) - sub_bucket_bits - 1 };
+
+	return shift * sub_buckets_count + static_cast<std::size_t>( clampedValue >> shift );
+}
+
+[[ nodiscard ]] inline constexpr std::uint64_t
+LatencyHistogram::getBucketUpperBound( const std::size_t bucketIdx ) noexcept
+{
+	if ( bucketIdx < 2 * sub_buckets_count ) { return bucketIdx; }
+
+	const std::size_t shift { bucketIdx / sub_buckets_count - 1 };
+	const std::uint64_t mantissa { bucketIdx - shift * sub_buckets_count };
+
+	return ( ( mantissa + 1 ) << shift ) - 1;
+}
+
+}
@@ -31,14 +31,29 @@
 namespace pynz = peyknowruzi;
 
 
-inline static void launch( [[ maybe_unused ]] int argc, [[ maybe_unused ]] char* argv[] )
+inline static int launch( int argc, char* argv[] )
 {
-	pynz::runScripts( );
+	const std::span<char* const> args { argv, static_cast<std::size_t>( argc ) };
+
+	try
+	{
+		pynz::runScripts( pynz::parse_options( args ) );
+	}
+	catch ( const std::bad_alloc& )
+	{
+		std::cerr << "Memory_Exception: Ran out of memory\n";
+		return EXIT_FAILURE;
+	}
+	catch ( const std::exception& ex )
+	{
+		std::cerr << ex.what( ) << '\n';
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
 }
 
 int main( int argc, char* argv[] )
 {
-	launch( argc, argv );
-
-	return 0;
+	return launch( argc, argv );
 }
@@ -0,0 +1,74 @@
+
+// PeykNowruzi - Basic ASCII-Art Generator
+// Copyright (C) 2021-2022 Kasra Hashemi
+
+/*
+
+ This file is part of PeykNowruzi.
+
+ PeykNowruzi is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License,
+ or (at your option) any later version.
+
+ PeykNowruzi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty
+ of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with PeykNowruzi. If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+
+#pragma once
+
+#include "pch.hpp"
+
+
+namespace peyknowruzi
+{
+
+enum class Execution_Mode
+{
+	sequenced,
+	parallel,
+};
+
+// where the canvas of a single drawing gets its memory from
+enum class Allocation_Strategy
+{
+	stack_allocated, // an arena on the stack
+	stack_heap_allocated, // the canvas on the stack, its cells on the heap
+	heap_allocated, // the canvas and its cells on the heap
+	pool_allocated, // a std::pmr::unsynchronized_pool_resource
+	huge_page_allocated, // an arena backed by huge pages
+	prefaulted, // an arena whose pages are all touched before drawing
+};
+
+// what the command line asked for, as collected by parse_options( )
+struct Options
+{
+	std::string_view inputFilePath { };
+	Execution_Mode executionMode { Execution_Mode::sequenced };
+	unsigned threadsCount { }; // 0 means one thread per hardware thread
+	bool isBatchMode { };
+	bool isPipelined { }; // implies isBatchMode
+	bool isRenderCached { }; // implies isBatchMode
+	std::size_t renderCacheBudget { }; // 0 means RenderCache::default_memory_budget
+	std::string_view renderCacheDirectory { }; // empty means no disk tier
+	Allocation_Strategy allocationStrategy { Allocation_Strategy::stack_allocated };
+	bool isAllocationBenchmark { }; // runs the input under every Allocation_Strategy
+	bool isLogoDrawn { }; // draws the built-in logo instead of reading any input
+	bool isCountersReported { };
+	std::string_view countersReportPath { }; // empty means the standard error
+	bool isLatencyReported { };
+	std::string_view latencyReportPath { }; // empty means the standard error
+};
+
+[[ nodiscard ]] std::string_view to_string( const Allocation_Strategy allocationStrategy ) noexcept;
+
+[[ nodiscard ]] Options parse_options( const std::span<char* const> args );
+
+}
@@ -0,0 +1,205 @@
+
+// PeykNowruzi - Basic ASCII-Art Generator
+// Copyright (C) 2021-2022 Kasra Hashemi
+
+/*
+
+ This file is part of PeykNowruzi.
+
+ PeykNowruzi is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License,
+ or (at your option) any later version.
+
+ PeykNowruzi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty
+ of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with PeykNowruzi. If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "RenderCache.hpp"
+#include "pch.hpp"
+
+
+namespace peyknowruzi
+{
+
+using std::uint32_t;
+using std::uint64_t;
+using std::size_t;
+
+[[ nodiscard ]] static constexpr uint64_t mix64( uint64_t value ) noexcept
+{
+	value ^= value >> 33;
+	value *= 0xFF51AFD7ED558CCD;
+	value ^= value >> 33;
+	value *= 0xC4CEB9FE1A85EC53;
+	value ^= value >> 33;
+
+	return value;
+}
+
+[[ nodiscard ]] RenderKey
+make_render_key( const uint32_t Y_AxisLen, const uint32_t X_AxisLen, const char fillCharacter,
+				 const std::span< const std::array<uint32_t, 4> > coordsOfChars ) noexcept
+{
+	RenderKey key { 0x243F6A8885A308D3, 0x13198A2E03707344 };
+
+	const auto absorb { [ &key ]( const uint64_t word )
+	{
+		key.low = std::rotl( key.low ^ mix64( word ), 27 ) * 0x9E3779B97F4A7C15;
+		key.high = std::rotl( key.high + mix64( word ^ 0xA4093822299F31D0 ), 31 ) * 0xC2B2AE3D27D4EB4F;
+	} };
+
+	absorb( ( uint64_t { Y_AxisLen } << 32 ) | X_AxisLen );
+	absorb( ( uint64_t { static_cast<unsigned char>( fillCharacter ) } << 32 ) | coordsOfChars.size( ) );
+
+	for ( const auto& [ x1, y1, x2, y2 ] : coordsOfChars )
+	{
+		absorb( ( uint64_t { x1 } << 32 ) | y1 );
+		absorb( ( uint64_t { x2 } << 32 ) | y2 );
+	}
+
+	key.low = mix64( key.low );
+	key.high = mix64( key.high );
+
+	return key;
+}
+
+RenderCache::RenderCache( const size_t memoryBudget, std::filesystem::path diskDirectory )
+
+	: m_memoryBudget( memoryBudget ), m_diskDirectory( std::move( diskDirectory ) )
+{
+	if ( m_diskDirectory.empty( ) ) { return; }
+
+	std::error_code ec;
+	std::filesystem::create_directories( m_diskDirectory, ec );
+
+	if ( ec || !std::filesystem::is_directory( m_diskDirectory ) )
+	{
+		throw std::runtime_error( "Render_Cache_Exception: Can not use '" + m_diskDirectory.string( ) +
+								  "' as a cache directory" );
+	}
+}
+
+[[ nodiscard ]] std::optional< std::string_view > RenderCache::find( const RenderKey& key )
+{
+	if ( const auto foundEntry { m_entriesByKey.find( key ) }; foundEntry != m_entriesByKey.end( ) )
+	{
+		m_entries.splice( m_entries.begin( ), m_entries, foundEntry->second );
+		++m_stats.memoryHits;
+
+		return foundEntry->second->renderedOutput;
+	}
+
+	if ( !m_diskDirectory.empty( ) )
+	{
+		std::ifstream cachedFile { getDiskPath( key ), std::ios::binary };
+		std::string renderedOutput { std::istreambuf_iterator<char> { cachedFile }, { } };
+
+		if ( cachedFile.is_open( ) && !cachedFile.bad( ) )
+		{
+			++m_stats.diskHits;
+
+			// too big for the memory tier, it is read from the disk on every hit
+			if ( renderedOutput.size( ) > m_memoryBudget )
+			{
+				m_oversizedOutput = std::move( renderedOutput );
+
+				return m_oversizedOutput;
+			}
+
+			// an entry that fits the budget is never the one evicted to make room for it
+			insertIntoMemory( key, std::move( renderedOutput ) );
+
+			return m_entries.front( ).renderedOutput;
+		}
+	}
+
+	++m_stats.misses;
+
+	return std::nullopt;
+}
+
+void RenderCache::insert( const RenderKey& key, std::string renderedOutput )
+{
+	if ( !m_diskDirectory.empty( ) ) { writeToDisk( key, renderedOutput ); }
+
+	insertIntoMemory( key, std::move( renderedOutput ) );
+}
+
+[[ nodiscard ]] const RenderCacheStats& RenderCache::getStats( ) const noexcept
+{
+	return m_stats;
+}
+
+[[ nodiscard ]] size_t RenderCache::getMemoryUsage( ) const noexcept
+{
+	return m_memoryUsage;
+}
+
+[[ nodiscard ]] std::filesystem::path RenderCache::getDiskPath( const RenderKey& key ) const
+{
+	static constexpr std::string_view hex_digits { "0123456789abcdef" };
+
+	std::string fileName( 32, '0' );
+
+	for ( size_t digitIdx { }; digitIdx < 16; ++digitIdx )
+	{
+		fileName[ 15 - digitIdx ] = hex_digits[ ( key.high >> ( digitIdx * 4 ) ) & 0xF ];
+		fileName[ 31 - digitIdx ] = hex_digits[ ( key.low >> ( digitIdx * 4 ) ) & 0xF ];
+	}
+
+	return m_diskDirectory / fileName;
+}
+
+void RenderCache::insertIntoMemory( const RenderKey& key, std::string renderedOutput )
+{
+	if ( const auto foundEntry { m_entriesByKey.find( key ) }; foundEntry != m_entriesByKey.end( ) )
+	{
+		m_memoryUsage -= foundEntry->second->renderedOutput.size( );
+		m_entries.erase( foundEntry->second );
+		m_entriesByKey.erase( foundEntry );
+	}
+
+	if ( renderedOutput.size( ) > m_memoryBudget ) { return; }
+
+	m_memoryUsage += renderedOutput.size( );
+	m_entries.push_front( Entry { key, std::move( renderedOutput ) } );
+	m_entriesByKey.emplace( key, m_entries.begin( ) );
+
+	while ( m_memoryUsage > m_memoryBudget )
+	{
+		m_memoryUsage -= m_entries.back( ).renderedOutput.size( );
+		m_entriesByKey.erase( m_entries.back( ).key );
+		m_entries.pop_back( );
+		++m_stats.evictions;
+	}
+}
+
+void RenderCache::writeToDisk( const RenderKey& key, const std::string_view renderedOutput ) const
+{
+	// written under a temporary name and renamed into place, so that a reader
+	// never sees a partial file; a failure only costs the disk tier this entry
+	const std::filesystem::path diskPath { getDiskPath( key ) };
+	std::filesystem::path temporaryPath { diskPath };
+	temporaryPath += ".tmp";
+
+	{
+		std::ofstream cachedFile { temporaryPath, std::ios::binary | std::ios::trunc };
+		cachedFile.write( renderedOutput.data( ), static_cast<std::streamsize>( renderedOutput.size( ) ) );
+
+		if ( !cachedFile ) { return; }
+	}
+
+	std::error_code ec;
+	std::filesystem::rename( temporaryPath, diskPath, ec );
+	if ( ec ) { std::filesystem::remove( temporaryPath, ec ); }
+}
+
+}
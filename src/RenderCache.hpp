@@ -0,0 +1,104 @@
+
+// PeykNowruzi - Basic ASCII-Art Generator
+// Copyright (C) 2021-2022 Kasra Hashemi
+
+/*
+
+ This file is part of PeykNowruzi.
+
+ PeykNowruzi is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License,
+ or (at your option) any later version.
+
+ PeykNowruzi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty
+ of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with PeykNowruzi. If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+
+#pragma once
+
+#include "pch.hpp"
+
+
+namespace peyknowruzi
+{
+
+// identifies one rendering: the matrix attributes and the coordinates in the
+// order they were given, hashed twice with independent seeds so that a
+// collision between two different inputs is practically impossible
+struct RenderKey
+{
+	std::uint64_t low;
+	std::uint64_t high;
+
+	bool operator==( const RenderKey& rhs ) const noexcept = default;
+};
+
+[[ nodiscard ]] RenderKey
+make_render_key( const std::uint32_t Y_AxisLen, const std::uint32_t X_AxisLen, const char fillCharacter,
+				 const std::span< const std::array<std::uint32_t, 4> > coordsOfChars ) noexcept;
+
+struct RenderCacheStats
+{
+	std::uint64_t memoryHits;
+	std::uint64_t diskHits;
+	std::uint64_t misses;
+	std::uint64_t evictions;
+};
+
+// Previously rendered output by the input it came from. The memory tier is an
+// LRU list whose entries are evicted once their total size exceeds the budget;
+// the optional disk tier keeps one file per rendering in a local directory,
+// survives the process and refills the memory tier on a hit. A RenderCache is
+// not synchronized, it belongs to the one thread that renders.
+class RenderCache
+{
+public:
+	static constexpr std::size_t default_memory_budget { 64 * 1024 * 1024 };
+
+	explicit RenderCache( const std::size_t memoryBudget = default_memory_budget,
+						  std::filesystem::path diskDirectory = { } );
+
+	// the returned output stays valid until the next call to insert( ) or find( )
+	[[ nodiscard ]] std::optional< std::string_view > find( const RenderKey& key );
+	void insert( const RenderKey& key, std::string renderedOutput );
+
+	[[ nodiscard ]] const RenderCacheStats& getStats( ) const noexcept;
+	[[ nodiscard ]] std::size_t getMemoryUsage( ) const noexcept;
+
+private:
+	struct RenderKeyHash
+	{
+		[[ nodiscard ]] std::size_t operator( )( const RenderKey& key ) const noexcept
+		{
+			return static_cast<std::size_t>( key.low );
+		}
+	};
+
+	struct Entry
+	{
+		RenderKey key;
+		std::string renderedOutput;
+	};
+
+	[[ nodiscard ]] std::filesystem::path getDiskPath( const RenderKey& key ) const;
+	void insertIntoMemory( const RenderKey& key, std::string renderedOutput );
+	void writeToDisk( const RenderKey& key, const std::string_view renderedOutput ) const;
+
+	std::size_t m_memoryBudget;
+	std::size_t m_memoryUsage { };
+	std::filesystem::path m_diskDirectory;
+	std::list<Entry> m_entries; // the most recently used entry first
+	std::unordered_map< RenderKey, std::list<Entry>::iterator, RenderKeyHash > m_entriesByKey;
+	std::string m_oversizedOutput;
+	RenderCacheStats m_stats { };
+};
+
+}
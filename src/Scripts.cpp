@@ -24,6 +24,8 @@
 
 #include "Scripts.hpp"
 #include "CharMatrix.hpp"
+#include "Counters.hpp"
+#include "Latency.hpp"
 #include "Log.hpp"
 #include "Util.hpp"
 #include "pch.hpp"
@@ -32,13 +34,174 @@
 namespace peyknowruzi
 {
 
-void runScripts( )
+static constexpr std::array allocation_strategy_names
 {
-	runScript( );
+	std::pair { Allocation_Strategy::stack_allocated, std::string_view { "stack" } },
+	std::pair { Allocation_Strategy::stack_heap_allocated, std::string_view { "stack-heap" } },
+	std::pair { Allocation_Strategy::heap_allocated, std::string_view { "heap" } },
+	std::pair { Allocation_Strategy::pool_allocated, std::string_view { "pool" } },
+	std::pair { Allocation_Strategy::huge_page_allocated, std::string_view { "hugepage" } },
+	std::pair { Allocation_Strategy::prefaulted, std::string_view { "prefault" } },
+};
+
+[[ nodiscard ]] std::string_view to_string( const Allocation_Strategy allocationStrategy ) noexcept
+{
+	const auto found { std::ranges::find( allocation_strategy_names, allocationStrategy,
+										  &decltype( allocation_strategy_names )::value_type::first ) };
+
+	return found != allocation_strategy_names.end( ) ? found->second : std::string_view { "unknown" };
+}
+
+[[ nodiscard ]] Options parse_options( const std::span<char* const> args )
+{
+	using std::string_view_literals::operator""sv;
+
+	static constexpr std::string_view threads_option_prefix { "--threads="sv };
+	static constexpr std::string_view cache_size_option_prefix { "--cache-size="sv };
+	static constexpr std::string_view cache_dir_option_prefix { "--cache-dir="sv };
+	static constexpr std::string_view alloc_option_prefix { "--alloc="sv };
+	static constexpr std::string_view counters_option_prefix { "--counters="sv };
+	static constexpr std::string_view latency_option_prefix { "--latency="sv };
+
+	Options options { };
+
+	for ( const std::string_view arg : args.subspan( std::min<std::size_t>( args.size( ), 1 ) ) )
+	{
+		if ( arg == "--parallel"sv )
+		{
+			options.executionMode = Execution_Mode::parallel;
+		}
+		else if ( arg == "--batch"sv )
+		{
+			options.isBatchMode = true;
+		}
+		else if ( arg == "--pipelined"sv )
+		{
+			options.isBatchMode = true;
+			options.isPipelined = true;
+		}
+		else if ( arg == "--cache"sv )
+		{
+			options.isBatchMode = true;
+			options.isRenderCached = true;
+		}
+		else if ( arg.starts_with( cache_size_option_prefix ) )
+		{
+			options.renderCacheBudget = util::parse_option_value<std::size_t>( arg, cache_size_option_prefix, 1 );
+
+			options.isBatchMode = true;
+			options.isRenderCached = true;
+		}
+		else if ( arg.starts_with( cache_dir_option_prefix ) )
+		{
+			options.renderCacheDirectory = arg.substr( cache_dir_option_prefix.size( ) );
+
+			if ( options.renderCacheDirectory.empty( ) )
+			{
+				throw std::runtime_error( "Invalid_Option_Exception: '" + std::string { arg } +
+										  "' expects a directory" );
+			}
+
+			options.isBatchMode = true;
+			options.isRenderCached = true;
+		}
+		else if ( arg.starts_with( alloc_option_prefix ) )
+		{
+			const std::string_view allocationStrategyName { arg.substr( alloc_option_prefix.size( ) ) };
+			const auto found { std::ranges::find( allocation_strategy_names, allocationStrategyName,
+												  &decltype( allocation_strategy_names )::value_type::second ) };
+
+			if ( found == allocation_strategy_names.end( ) )
+			{
+				throw std::runtime_error( "Invalid_Option_Exception: '" + std::string { arg } +
+										  "' expects one of stack, stack-heap, heap, pool, hugepage or prefault" );
+			}
+
+			options.allocationStrategy = found->first;
+		}
+		else if ( arg == "--counters"sv )
+		{
+			options.isCountersReported = true;
+		}
+		else if ( arg.starts_with( counters_option_prefix ) )
+		{
+			options.countersReportPath = arg.substr( counters_option_prefix.size( ) );
+
+			if ( options.countersReportPath.empty( ) )
+			{
+				throw std::runtime_error( "Invalid_Option_Exception: '" + std::string { arg } + "' expects a file" );
+			}
+
+			options.isCountersReported = true;
+		}
+		else if ( arg == "--latency"sv )
+		{
+			options.isLatencyReported = true;
+		}
+		else if ( arg.starts_with( latency_option_prefix ) )
+		{
+			options.latencyReportPath = arg.substr( latency_option_prefix.size( ) );
+
+			if ( options.latencyReportPath.empty( ) )
+			{
+				throw std::runtime_error( "Invalid_Option_Exception: '" + std::string { arg } + "' expects a file" );
+			}
+
+			options.isLatencyReported = true;
+		}
+		else if ( arg == "--bench-alloc"sv )
+		{
+			options.isAllocationBenchmark = true;
+		}
+		else if ( arg == "--logo"sv )
+		{
+			options.isLogoDrawn = true;
+		}
+		else if ( arg.starts_with( threads_option_prefix ) )
+		{
+			options.threadsCount = util::parse_option_value<unsigned>( arg, threads_option_prefix, 1 );
+
+			options.executionMode = Execution_Mode::parallel;
+		}
+		else if ( arg.starts_with( "--"sv ) )
+		{
+			throw std::runtime_error( "Invalid_Option_Exception: Unknown option '" + std::string { arg } + "'" );
+		}
+		else if ( options.inputFilePath.empty( ) )
+		{
+			options.inputFilePath = arg;
+		}
+		else
+		{
+			throw std::runtime_error( "Invalid_Option_Exception: Unexpected argument '" + std::string { arg } + "'" );
+		}
+	}
+
+	if ( options.isAllocationBenchmark && options.isBatchMode )
+	{
+		throw std::runtime_error( "Invalid_Option_Exception: '--bench-alloc' can not be combined with the batch modes" );
+	}
+
+	return options;
+}
+
+void runScripts( const Options& options )
+{
+	if ( options.isCountersReported ) { counters::enable_report( options.countersReportPath ); }
+	if ( options.isLatencyReported ) { latency::enable_report( options.latencyReportPath ); }
+
+	runScript( options );
 }
 
 void exit_handler( )
 {
+	try
+	{
+		counters::write_report( );
+		latency::write_report( );
+	}
+	catch ( const std::exception& ) { }
+
 #if PN_DEBUG == 1
 	using std::string_literals::operator""s;
 
@@ -24,11 +24,12 @@
 
 #pragma once
 
+#include "Options.hpp"
 
 namespace peyknowruzi
 {
 
-void runScripts( );
+void runScripts( const Options& options );
 
 void exit_handler( );
 
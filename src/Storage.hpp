@@ -0,0 +1,1623 @@
+
+// PeykNowruzi - Basic ASCII-Art Generator
+// Copyright (C) 2021-2022 Kasra Hashemi
+
+/*
+
+ This file is part of PeykNowruzi.
+
+ PeykNowruzi is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License,
+ or (at your option) any later version.
+
+ PeykNowruzi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty
+ of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with PeykNowruzi. If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+
+
+#pragma once
+
+#include "pch.hpp"
+#include "Util.hpp"
+
+
+namespace peyknowruzi
+{
+
+// Storage policies hold the cells of a CharMatrix. Each one keeps its own copy
+// of the geometry it needs and exposes the same small interface: cell access
+// through at( ), the three setters that mirror the ones of CharMatrix and draw( ).
+// The last column of every row is the newline column; a policy either stores it
+// or produces it while drawing. draw( util::FdOutput& ) hands out chunks of the
+// policy's own memory wherever it can instead of copying them. A policy whose
+// non-const at( ) only touches state of the rows its cell is grouped with sets
+// supports_concurrent_row_bands, which lets disjoint bands of rows be written
+// from different threads as long as every band starts on a multiple of
+// row_band_alignment. A policy whose non-const at( ) may throw clears
+// is_nothrow_access, which takes noexcept off the CharMatrix writes built on it.
+
+template < class Allocator = std::allocator<char> >
+class DenseStorage
+{
+public:
+	using allocator_type = Allocator;
+	using reference = char&;
+	using const_reference = const char&;
+
+	static constexpr std::uint32_t min_y_axis_len { 1 };
+	static constexpr std::uint32_t min_x_axis_len { 2 };
+	static constexpr std::uint32_t max_y_axis_len { 50 };
+	static constexpr std::uint32_t max_x_axis_len { 168 };
+
+	static constexpr bool supports_concurrent_row_bands { true };
+	static constexpr std::size_t row_band_alignment { 1 };
+	static constexpr bool is_nothrow_access { true };
+
+	DenseStorage( const std::uint32_t Y_AxisLen, const std::uint32_t X_AxisLen,
+				  const char fillCharacter, const Allocator& alloc );
+	DenseStorage( DenseStorage&& rhs ) noexcept;
+	DenseStorage& operator=( DenseStorage&& rhs ) noexcept;
+
+	[[ nodiscard ]] bool empty( ) const noexcept;
+	[[ nodiscard ]] allocator_type get_allocator( ) const noexcept;
+	[[ nodiscard ]] reference at( const std::size_t X_Axis, const std::size_t Y_Axis ) noexcept;
+	[[ nodiscard ]] const_reference at( const std::size_t X_Axis, const std::size_t Y_Axis ) const noexcept;
+
+	[[ nodiscard ]] std::vector<char, Allocator>& getCharacterMatrix( ) noexcept;
+	[[ nodiscard ]] const std::vector<char, Allocator>& getCharacterMatrix( ) const noexcept;
+
+	void setY_AxisLen( const std::uint32_t Y_AxisLen );
+	void setX_AxisLen( const std::uint32_t X_AxisLen );
+	void setFillCharacter( const char fillCharacter );
+	void draw( std::ostream& output_stream ) const;
+	void draw( util::FdOutput& output ) const;
+
+private:
+	std::uint32_t m_Y_AxisLen;
+	std::uint32_t m_X_AxisLen;
+	char m_fillCharacter;
+	std::vector<char, Allocator> m_characterMatrix;
+};
+
+// Splits the canvas into 64 x 64 tiles ( 4 KiB, one page each ) that are
+// allocated on first write, so memory grows with the area that is actually
+// drawn on instead of with Y * X. Untouched tiles read as the fill character.
+template < class Allocator = std::allocator<char> >
+class TiledStorage
+{
+public:
+	using allocator_type = Allocator;
+	using reference = char&;
+	using const_reference = const char&;
+
+	static constexpr std::uint32_t min_y_axis_len { 1 };
+	static constexpr std::uint32_t min_x_axis_len { 2 };
+	// the tile index holds a row of tiles per 64 rows, a drawn row of tiles holds
+	// a tile per 64 columns and drawing builds one whole row of fill characters,
+	// so 2^26 keeps each of them within tens of MiB
+	static constexpr std::uint32_t max_y_axis_len { std::uint32_t { 1 } << 26 };
+	static constexpr std::uint32_t max_x_axis_len { std::uint32_t { 1 } << 26 };
+
+	static constexpr std::size_t tile_edge_shift { 6 };
+	static constexpr std::size_t tile_edge_len { std::size_t { 1 } << tile_edge_shift };
+
+	// a band of whole tile rows allocates only its own tiles and counts them in
+	// its own tile rows, but it allocates them from the same allocator as every
+	// other band, which a stateless one allows and a memory resource need not
+	static constexpr bool supports_concurrent_row_bands { std::allocator_traits<Allocator>::is_always_equal::value };
+	static constexpr std::size_t row_band_alignment { tile_edge_len };
+	static constexpr bool is_nothrow_access { false };
+
+	TiledStorage( const std::uint32_t Y_AxisLen, const std::uint32_t X_AxisLen,
+				  const char fillCharacter, const Allocator& alloc );
+	TiledStorage( TiledStorage&& rhs ) noexcept;
+	TiledStorage& operator=( TiledStorage&& rhs ) noexcept;
+	~TiledStorage( );
+
+	[[ nodiscard ]] bool empty( ) const noexcept;
+	// allocates the tile of the cell on first touch
+	[[ nodiscard ]] reference at( const std::size_t X_Axis, const std::size_t Y_Axis );
+	[[ nodiscard ]] const_reference at( const std::size_t X_Axis, const std::size_t Y_Axis ) const noexcept;
+	[[ nodiscard ]] std::size_t getAllocatedTilesCount( ) const noexcept;
+
+	void setY_AxisLen( const std::uint32_t Y_AxisLen );
+	void setX_AxisLen( const std::uint32_t X_AxisLen );
+	void setFillCharacter( const char fillCharacter );
+	void draw( std::ostream& output_stream ) const;
+	void draw( util::FdOutput& output ) const;
+
+private:
+	struct Tile
+	{
+		std::array<char, tile_edge_len * tile_edge_len> cells;
+	};
+
+	using alloc_traits = std::allocator_traits<Allocator>;
+	using tile_allocator_type = typename alloc_traits::template rebind_alloc<Tile>;
+	using tile_alloc_traits = std::allocator_traits<tile_allocator_type>;
+	using tile_row = std::vector< Tile*, typename alloc_traits::template rebind_alloc<Tile*> >;
+	using tile_rows = std::vector< tile_row, typename alloc_traits::template rebind_alloc<tile_row> >;
+	using tile_counts = std::vector< std::size_t, typename alloc_traits::template rebind_alloc<std::size_t> >;
+
+	[[ nodiscard ]] static constexpr std::size_t tiles_count_for( const std::uint32_t axisLen ) noexcept;
+
+	[[ nodiscard ]] Tile* allocateTile( );
+	void deallocateTile( Tile* const tile ) noexcept;
+	void releaseTiles( ) noexcept;
+	void stealOrCopyTiles( TiledStorage& rhs );
+
+	tile_allocator_type m_tileAllocator;
+	std::uint32_t m_Y_AxisLen;
+	std::uint32_t m_X_AxisLen;
+	char m_fillCharacter;
+	tile_rows m_tileRows;
+	// the tiles allocated in each tile row, kept per tile row rather than as one
+	// total so that bands of tile rows written from different threads never
+	// share a count; getAllocatedTilesCount( ) sums them
+	tile_counts m_allocatedTilesCounts;
+};
+
+// Keeps only the cells that were written to, as rows of cells sorted by X that
+// are themselves sorted by Y, so memory grows with the number of drawn cells.
+// Fill characters and newlines only exist in the output of draw( ).
+template < class Allocator = std::allocator<char> >
+class SparseStorage
+{
+public:
+	using allocator_type = Allocator;
+	using reference = char&;
+	using const_reference = const char&;
+
+	static constexpr std::uint32_t min_y_axis_len { 1 };
+	static constexpr std::uint32_t min_x_axis_len { 2 };
+	static constexpr std::uint32_t max_y_axis_len { std::numeric_limits<std::uint32_t>::max( ) };
+	static constexpr std::uint32_t max_x_axis_len { std::numeric_limits<std::uint32_t>::max( ) };
+
+	static constexpr bool supports_concurrent_row_bands { false };
+	static constexpr std::size_t row_band_alignment { 1 };
+	static constexpr bool is_nothrow_access { false };
+
+	SparseStorage( const std::uint32_t Y_AxisLen, const std::uint32_t X_AxisLen,
+				   const char fillCharacter, const Allocator& alloc );
+	SparseStorage( SparseStorage&& rhs ) noexcept;
+	SparseStorage& operator=( SparseStorage&& rhs ) noexcept;
+
+	[[ nodiscard ]] bool empty( ) const noexcept;
+	// inserts the cell on first touch
+	[[ nodiscard ]] reference at( const std::size_t X_Axis, const std::size_t Y_Axis );
+	[[ nodiscard ]] const_reference at( const std::size_t X_Axis, const std::size_t Y_Axis ) const noexcept;
+	[[ nodiscard ]] std::size_t getOccupiedCellsCount( ) const noexcept;
+
+	void setY_AxisLen( const std::uint32_t Y_AxisLen );
+	void setX_AxisLen( const std::uint32_t X_AxisLen );
+	void setFillCharacter( const char fillCharacter );
+	void draw( std::ostream& output_stream ) const;
+	void draw( util::FdOutput& output ) const;
+
+private:
+	struct Cell
+	{
+		std::uint32_t X_Axis;
+		char ch;
+	};
+
+	using alloc_traits = std::allocator_traits<Allocator>;
+	using cell_row = std::vector< Cell, typename alloc_traits::template rebind_alloc<Cell> >;
+
+	struct Row
+	{
+		std::uint32_t Y_Axis;
+		cell_row cells;
+	};
+
+	using cell_rows = std::vector< Row, typename alloc_traits::template rebind_alloc<Row> >;
+
+	std::uint32_t m_Y_AxisLen;
+	std::uint32_t m_X_AxisLen;
+	char m_fillCharacter;
+	cell_rows m_rows;
+};
+
+// Lays the rows out at a stride that is a multiple of 64 bytes, with the first
+// row on a 64 byte boundary, so every row starts on its own cache line and can
+// be read with aligned vector loads. Newlines only exist in the output of draw( ).
+// The padding after the cells of a row always holds the fill character, which
+// lets a row grow within its stride without touching any memory.
+template < class Allocator = std::allocator<char> >
+class StridedStorage
+{
+public:
+	using allocator_type = Allocator;
+	using reference = char&;
+	using const_reference = const char&;
+
+	static constexpr std::uint32_t min_y_axis_len { 1 };
+	static constexpr std::uint32_t min_x_axis_len { 2 };
+	static constexpr std::uint32_t max_y_axis_len { DenseStorage<Allocator>::max_y_axis_len };
+	static constexpr std::uint32_t max_x_axis_len { DenseStorage<Allocator>::max_x_axis_len };
+
+	static constexpr bool supports_concurrent_row_bands { true };
+	static constexpr std::size_t row_band_alignment { 1 };
+	static constexpr bool is_nothrow_access { true };
+
+	static constexpr std::size_t row_alignment { 64 };
+
+	StridedStorage( const std::uint32_t Y_AxisLen, const std::uint32_t X_AxisLen,
+					const char fillCharacter, const Allocator& alloc );
+	StridedStorage( StridedStorage&& rhs ) noexcept;
+	StridedStorage& operator=( StridedStorage&& rhs ) noexcept;
+
+	[[ nodiscard ]] bool empty( ) const noexcept;
+	[[ nodiscard ]] allocator_type get_allocator( ) const noexcept;
+	[[ nodiscard ]] reference at( const std::size_t X_Axis, const std::size_t Y_Axis ) noexcept;
+	[[ nodiscard ]] const_reference at( const std::size_t X_Axis, const std::size_t Y_Axis ) const noexcept;
+	[[ nodiscard ]] std::size_t getRowStride( ) const noexcept;
+	// every row, getRowStride( ) bytes each, padding included
+	[[ nodiscard ]] std::string_view getRows( ) const noexcept;
+
+	void setY_AxisLen( const std::uint32_t Y_AxisLen );
+	void setX_AxisLen( const std::uint32_t X_AxisLen );
+	void setFillCharacter( const char fillCharacter );
+	void draw( std::ostream& output_stream ) const;
+	void draw( util::FdOutput& output ) const;
+
+private:
+	[[ nodiscard ]] static constexpr std::size_t row_stride_for( const std::uint32_t X_AxisLen ) noexcept;
+	[[ nodiscard ]] static std::size_t aligned_offset_of( const char* const address ) noexcept;
+
+	// the buffer is allocator_type's memory, so it is aligned by hand: it holds
+	// row_alignment - 1 bytes more than the rows need and they start at
+	// m_firstRowOffset, which has to be found again whenever the buffer moves
+	void realignRows( const std::size_t previousFirstRowOffset, const std::size_t rowsSize ) noexcept;
+
+	std::uint32_t m_Y_AxisLen;
+	std::uint32_t m_X_AxisLen;
+	char m_fillCharacter;
+	std::size_t m_rowStride;
+	std::size_t m_firstRowOffset;
+	std::vector<char, Allocator> m_buffer;
+};
+
+// Stores every cell as a 4 bit code into a palette of 16 characters, two cells
+// per byte, which halves the memory of a dense canvas. Code 0 is always the fill
+// character and codes 1 to 4 the characters lines are drawn with, the rest are
+// handed out to other characters as they are written; a seventeenth distinct
+// character can not be stored. Every row starts on a byte of its own, so rows
+// never share memory. Cells are read and written through a proxy reference.
+template < class Allocator = std::allocator<char> >
+class PackedStorage
+{
+public:
+	using allocator_type = Allocator;
+
+	class reference
+	{
+	public:
+		reference( PackedStorage& storage, unsigned char& packedCells, const unsigned shift ) noexcept;
+		reference( const reference& ) = default;
+
+		reference& operator=( const char ch );
+		reference& operator=( const reference& rhs );
+		operator char( ) const noexcept;
+
+	private:
+		PackedStorage* m_storage;
+		unsigned char* m_packedCells;
+		unsigned m_shift;
+	};
+
+	using const_reference = char;
+
+	static constexpr std::uint32_t min_y_axis_len { 1 };
+	static constexpr std::uint32_t min_x_axis_len { 2 };
+	static constexpr std::uint32_t max_y_axis_len { std::numeric_limits<std::uint32_t>::max( ) };
+	static constexpr std::uint32_t max_x_axis_len { std::numeric_limits<std::uint32_t>::max( ) };
+
+	static constexpr bool supports_concurrent_row_bands { true };
+	static constexpr std::size_t row_band_alignment { 1 };
+	static constexpr bool is_nothrow_access { true };
+
+	static constexpr std::size_t palette_size { 16 };
+	static constexpr std::array<char, 4> line_characters { '-', '\\', '/', '|' };
+
+	PackedStorage( const std::uint32_t Y_AxisLen, const std::uint32_t X_AxisLen,
+				   const char fillCharacter, const Allocator& alloc );
+	PackedStorage( PackedStorage&& rhs ) noexcept;
+	PackedStorage& operator=( PackedStorage&& rhs ) noexcept;
+
+	[[ nodiscard ]] bool empty( ) const noexcept;
+	[[ nodiscard ]] allocator_type get_allocator( ) const noexcept;
+	[[ nodiscard ]] reference at( const std::size_t X_Axis, const std::size_t Y_Axis ) noexcept;
+	[[ nodiscard ]] const_reference at( const std::size_t X_Axis, const std::size_t Y_Axis ) const noexcept;
+	[[ nodiscard ]] std::size_t getPackedSize( ) const noexcept;
+
+	void setY_AxisLen( const std::uint32_t Y_AxisLen );
+	void setX_AxisLen( const std::uint32_t X_AxisLen );
+	void setFillCharacter( const char fillCharacter );
+	void draw( std::ostream& output_stream ) const;
+	void draw( util::FdOutput& output ) const;
+
+private:
+	static constexpr unsigned char no_code { 0xFF };
+
+	using packed_cells_type = std::vector< unsigned char,
+										   typename std::allocator_traits<Allocator>::template rebind_alloc<unsigned char> >;
+
+	[[ nodiscard ]] static constexpr std::size_t row_size_for( const std::uint32_t X_AxisLen ) noexcept;
+	[[ nodiscard ]] unsigned char getCode( const char ch );
+	// the code a line character keeps for good, no_code for any other character
+	[[ nodiscard ]] static constexpr unsigned char reserved_code_of( const char ch ) noexcept;
+	void recodeCells( const unsigned char fromCode, const unsigned char toCode ) noexcept;
+	// hands the last code of the palette the place of code, which no cell may hold
+	void releaseCode( const unsigned char code ) noexcept;
+	// writes Y_Axis to the end of expandedRow_OUT, newline included
+	void expandRow( const std::size_t Y_Axis, char* const expandedRow_OUT ) const noexcept;
+
+	std::uint32_t m_Y_AxisLen;
+	std::uint32_t m_X_AxisLen;
+	char m_fillCharacter;
+	std::size_t m_rowSize;
+	std::size_t m_paletteLen;
+	std::array<char, palette_size> m_palette;
+	std::array<unsigned char, 256> m_codes;
+	packed_cells_type m_packedCells;
+};
+
+
+template <class Allocator>
+inline DenseStorage<Allocator>::DenseStorage( const std::uint32_t Y_AxisLen, const std::uint32_t X_AxisLen,
+											  const char fillCharacter, const Allocator& alloc )
+
+	: m_Y_AxisLen( Y_AxisLen ), m_X_AxisLen( X_AxisLen ), m_fillCharacter( fillCharacter ),
+	  m_characterMatrix( std::size_t { Y_AxisLen } * X_AxisLen, fillCharacter, alloc )
+{
+	for ( std::size_t last_idx_of_row { m_X_AxisLen - 1 }; last_idx_of_row < m_characterMatrix.size( )
+		  ; last_idx_of_row += m_X_AxisLen )
+	{
+		m_characterMatrix[ last_idx_of_row ] = '\n';
+	}
+}
+
+template <class Allocator>
+inline DenseStorage<Allocator>::DenseStorage( DenseStorage<Allocator>&& rhs ) noexcept
+
+	: m_Y_AxisLen( rhs.m_Y_AxisLen ), m_X_AxisLen( rhs.m_X_AxisLen ), m_fillCharacter( rhs.m_fillCharacter ),
+	  m_characterMatrix( std::move( rhs.m_characterMatrix ) )
+{
+	rhs.m_Y_AxisLen = 0;
+	rhs.m_X_AxisLen = 0;
+	rhs.m_fillCharacter = 0;
+}
+
+template <class Allocator>
+inline DenseStorage<Allocator>& DenseStorage<Allocator>::operator=( DenseStorage<Allocator>&& rhs ) noexcept
+{
+	if ( this != &rhs )
+	{
+		m_characterMatrix = std::move( rhs.m_characterMatrix );
+		m_Y_AxisLen = rhs.m_Y_AxisLen;
+		m_X_AxisLen = rhs.m_X_AxisLen;
+		m_fillCharacter = rhs.m_fillCharacter;
+
+		rhs.m_Y_AxisLen = 0;
+		rhs.m_X_AxisLen = 0;
+		rhs.m_fillCharacter = 0;
+	}
+
+	return *this;
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline bool DenseStorage<Allocator>::empty( ) const noexcept
+{
+	return m_characterMatrix.empty( );
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline Allocator DenseStorage<Allocator>::get_allocator( ) const noexcept
+{
+	return m_characterMatrix.get_allocator( );
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline char&
+DenseStorage<Allocator>::at( const std::size_t X_Axis, const std::size_t Y_Axis ) noexcept
+{
+	return m_characterMatrix[ Y_Axis * m_X_AxisLen + X_Axis ];
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline const char&
+DenseStorage<Allocator>::at( const std::size_t X_Axis, const std::size_t Y_Axis ) const noexcept
+{
+	return m_characterMatrix[ Y_Axis * m_X_AxisLen + X_Axis ];
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline std::vector<char, Allocator>&
+DenseStorage<Allocator>::getCharacterMatrix( ) noexcept
+{
+	return m_characterMatrix;
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline const std::vector<char, Allocator>&
+DenseStorage<Allocator>::getCharacterMatrix( ) const noexcept
+{
+	return m_characterMatrix;
+}
+
+template <class Allocator>
+void DenseStorage<Allocator>::setY_AxisLen( const std::uint32_t Y_AxisLen )
+{
+	const std::uint32_t& current_Y_AxisLen { m_Y_AxisLen };
+	const std::uint32_t& new_Y_AxisLen { Y_AxisLen };
+
+	if ( new_Y_AxisLen == current_Y_AxisLen ) { return; }
+
+	if ( new_Y_AxisLen > current_Y_AxisLen )
+	{
+		m_characterMatrix.resize( m_characterMatrix.size( ) + ( new_Y_AxisLen - current_Y_AxisLen ) *
+								  m_X_AxisLen, m_fillCharacter );
+
+		for ( std::size_t last_idx_of_row { ( current_Y_AxisLen + 1 ) * m_X_AxisLen - 1 }
+			  ; last_idx_of_row < m_characterMatrix.size( ); last_idx_of_row += m_X_AxisLen )
+		{
+			m_characterMatrix[ last_idx_of_row ] = '\n';
+		}
+	}
+	else
+	{
+		m_characterMatrix.resize( m_characterMatrix.size( ) - ( current_Y_AxisLen - new_Y_AxisLen ) *
+								  m_X_AxisLen );
+	}
+
+	m_Y_AxisLen = { new_Y_AxisLen };
+}
+
+template <class Allocator>
+void DenseStorage<Allocator>::setX_AxisLen( const std::uint32_t X_AxisLen )
+{
+	const std::uint32_t& current_X_AxisLen { m_X_AxisLen };
+	const std::uint32_t& new_X_AxisLen { X_AxisLen };
+
+	if ( new_X_AxisLen == current_X_AxisLen ) { return; }
+
+	if ( new_X_AxisLen > current_X_AxisLen )
+	{
+		m_characterMatrix.resize( m_Y_AxisLen * new_X_AxisLen, m_fillCharacter );
+
+		for ( auto new_pos { m_characterMatrix.end( ) - 1 },
+			  old_pos { m_characterMatrix.begin( ) + ( m_Y_AxisLen - 1 ) * current_X_AxisLen }
+			  ; old_pos >= m_characterMatrix.begin( ); old_pos -= current_X_AxisLen, --new_pos )
+		{
+			*new_pos = '\n';
+
+			new_pos -= new_X_AxisLen - current_X_AxisLen;
+			std::fill_n( new_pos, new_X_AxisLen - current_X_AxisLen, m_fillCharacter );
+
+			new_pos -= current_X_AxisLen - 1;
+			std::copy_n( old_pos, current_X_AxisLen - 1, new_pos );
+		}
+	}
+	else
+	{
+		for ( auto new_pos { m_characterMatrix.begin( ) },
+			  old_pos { m_characterMatrix.begin( ) }
+			  ; old_pos != m_characterMatrix.end( ); old_pos += current_X_AxisLen, ++new_pos )
+		{
+			std::copy_n( old_pos, new_X_AxisLen - 1, new_pos );
+
+			new_pos += new_X_AxisLen - 1;
+			*new_pos = '\n';
+		}
+
+		m_characterMatrix.resize( m_Y_AxisLen * new_X_AxisLen );
+	}
+
+	m_X_AxisLen = { new_X_AxisLen };
+}
+
+template <class Allocator>
+void DenseStorage<Allocator>::setFillCharacter( const char fillCharacter )
+{
+	std::ranges::replace( m_characterMatrix, m_fillCharacter, fillCharacter );
+
+	m_fillCharacter = { fillCharacter };
+}
+
+template <class Allocator>
+inline void DenseStorage<Allocator>::draw( std::ostream& output_stream ) const
+{
+	output_stream.write( m_characterMatrix.data( ), static_cast<std::streamsize>( m_characterMatrix.size( ) ) );
+}
+
+template <class Allocator>
+inline void DenseStorage<Allocator>::draw( util::FdOutput& output ) const
+{
+	output.append( { m_characterMatrix.data( ), m_characterMatrix.size( ) } );
+	output.flush( );
+}
+
+
+template <class Allocator>
+inline TiledStorage<Allocator>::TiledStorage( const std::uint32_t Y_AxisLen, const std::uint32_t X_AxisLen,
+											  const char fillCharacter, const Allocator& alloc )
+
+	: m_tileAllocator( alloc ), m_Y_AxisLen( Y_AxisLen ), m_X_AxisLen( X_AxisLen ),
+	  m_fillCharacter( fillCharacter ), m_tileRows( tiles_count_for( Y_AxisLen ), alloc ),
+	  m_allocatedTilesCounts( tiles_count_for( Y_AxisLen ), 0, alloc )
+{
+}
+
+template <class Allocator>
+inline TiledStorage<Allocator>::TiledStorage( TiledStorage<Allocator>&& rhs ) noexcept
+
+	: m_tileAllocator( rhs.m_tileAllocator ), m_Y_AxisLen( rhs.m_Y_AxisLen ), m_X_AxisLen( rhs.m_X_AxisLen ),
+	  m_fillCharacter( rhs.m_fillCharacter ), m_tileRows( std::move( rhs.m_tileRows ) ),
+	  m_allocatedTilesCounts( std::move( rhs.m_allocatedTilesCounts ) )
+{
+	rhs.m_tileRows.clear( );
+	rhs.m_allocatedTilesCounts.clear( );
+	rhs.m_Y_AxisLen = 0;
+	rhs.m_X_AxisLen = 0;
+	rhs.m_fillCharacter = 0;
+}
+
+template <class Allocator>
+inline TiledStorage<Allocator>& TiledStorage<Allocator>::operator=( TiledStorage<Allocator>&& rhs ) noexcept
+{
+	if ( this != &rhs )
+	{
+		releaseTiles( );
+		stealOrCopyTiles( rhs );
+
+		m_Y_AxisLen = rhs.m_Y_AxisLen;
+		m_X_AxisLen = rhs.m_X_AxisLen;
+		m_fillCharacter = rhs.m_fillCharacter;
+
+		rhs.m_Y_AxisLen = 0;
+		rhs.m_X_AxisLen = 0;
+		rhs.m_fillCharacter = 0;
+	}
+
+	return *this;
+}
+
+template <class Allocator>
+inline TiledStorage<Allocator>::~TiledStorage( )
+{
+	releaseTiles( );
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline bool TiledStorage<Allocator>::empty( ) const noexcept
+{
+	return m_tileRows.empty( );
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline char&
+TiledStorage<Allocator>::at( const std::size_t X_Axis, const std::size_t Y_Axis )
+{
+	const std::size_t tileRowIdx { Y_Axis >> tile_edge_shift };
+	tile_row& tileRow { m_tileRows[ tileRowIdx ] };
+
+	if ( tileRow.empty( ) ) [[ unlikely ]]
+	{
+		tileRow.resize( tiles_count_for( m_X_AxisLen ), nullptr );
+	}
+
+	Tile*& tile { tileRow[ X_Axis >> tile_edge_shift ] };
+
+	if ( tile == nullptr ) [[ unlikely ]]
+	{
+		tile = allocateTile( );
+		++m_allocatedTilesCounts[ tileRowIdx ];
+	}
+
+	return tile->cells[ ( ( Y_Axis & ( tile_edge_len - 1 ) ) << tile_edge_shift ) +
+						( X_Axis & ( tile_edge_len - 1 ) ) ];
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline const char&
+TiledStorage<Allocator>::at( const std::size_t X_Axis, const std::size_t Y_Axis ) const noexcept
+{
+	const tile_row& tileRow { m_tileRows[ Y_Axis >> tile_edge_shift ] };
+
+	if ( tileRow.empty( ) || tileRow[ X_Axis >> tile_edge_shift ] == nullptr ) { return m_fillCharacter; }
+
+	return tileRow[ X_Axis >> tile_edge_shift ]->cells[ ( ( Y_Axis & ( tile_edge_len - 1 ) ) << tile_edge_shift ) +
+														 ( X_Axis & ( tile_edge_len - 1 ) ) ];
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline std::size_t
+TiledStorage<Allocator>::getAllocatedTilesCount( ) const noexcept
+{
+	return std::reduce( m_allocatedTilesCounts.begin( ), m_allocatedTilesCounts.end( ), std::size_t { 0 } );
+}
+
+template <class Allocator>
+void TiledStorage<Allocator>::setY_AxisLen( const std::uint32_t Y_AxisLen )
+{
+	const std::uint32_t& current_Y_AxisLen { m_Y_AxisLen };
+	const std::uint32_t& new_Y_AxisLen { Y_AxisLen };
+
+	if ( new_Y_AxisLen == current_Y_AxisLen ) { return; }
+
+	if ( new_Y_AxisLen < current_Y_AxisLen )
+	{
+		// drop the tile rows that fall outside and clear the cut-off part of the
+		// last remaining one so that growing again shows the fill character
+		for ( std::size_t tileRowIdx { tiles_count_for( new_Y_AxisLen ) }; tileRowIdx < m_tileRows.size( ); ++tileRowIdx )
+		{
+			for ( Tile* const tile : m_tileRows[ tileRowIdx ] ) { deallocateTile( tile ); }
+		}
+
+		const std::size_t firstClearedRow { new_Y_AxisLen & ( tile_edge_len - 1 ) };
+
+		if ( firstClearedRow != 0 )
+		{
+			for ( Tile* const tile : m_tileRows[ new_Y_AxisLen >> tile_edge_shift ] )
+			{
+				if ( tile == nullptr ) { continue; }
+
+				std::fill( tile->cells.begin( ) + static_cast<std::ptrdiff_t>( firstClearedRow << tile_edge_shift ),
+						   tile->cells.end( ), m_fillCharacter );
+			}
+		}
+	}
+
+	m_tileRows.resize( tiles_count_for( new_Y_AxisLen ) );
+	m_allocatedTilesCounts.resize( tiles_count_for( new_Y_AxisLen ), 0 );
+
+	m_Y_AxisLen = { new_Y_AxisLen };
+}
+
+template <class Allocator>
+void TiledStorage<Allocator>::setX_AxisLen( const std::uint32_t X_AxisLen )
+{
+	const std::uint32_t& current_X_AxisLen { m_X_AxisLen };
+	const std::uint32_t& new_X_AxisLen { X_AxisLen };
+
+	if ( new_X_AxisLen == current_X_AxisLen ) { return; }
+
+	// the last column is where the newline goes, so the cut-off part starts there
+	const std::size_t newTileColsCount { tiles_count_for( new_X_AxisLen ) };
+	const std::size_t keptTileColsCount { tiles_count_for( new_X_AxisLen - 1 ) };
+	const std::size_t firstClearedCol { ( new_X_AxisLen - 1 ) & ( tile_edge_len - 1 ) };
+
+	for ( std::size_t tileRowIdx { }; tileRowIdx < m_tileRows.size( ); ++tileRowIdx )
+	{
+		tile_row& tileRow { m_tileRows[ tileRowIdx ] };
+
+		if ( tileRow.empty( ) ) { continue; }
+
+		if ( new_X_AxisLen < current_X_AxisLen )
+		{
+			for ( std::size_t tileColIdx { keptTileColsCount }; tileColIdx < tileRow.size( ); ++tileColIdx )
+			{
+				if ( tileRow[ tileColIdx ] == nullptr ) { continue; }
+
+				deallocateTile( std::exchange( tileRow[ tileColIdx ], nullptr ) );
+				--m_allocatedTilesCounts[ tileRowIdx ];
+			}
+
+			if ( Tile* const tile { tileRow[ keptTileColsCount - 1 ] }; tile != nullptr && firstClearedCol != 0 )
+			{
+				for ( std::size_t row_offset { }; row_offset < tile->cells.size( ); row_offset += tile_edge_len )
+				{
+					std::fill_n( tile->cells.begin( ) + static_cast<std::ptrdiff_t>( row_offset + firstClearedCol ),
+								 tile_edge_len - firstClearedCol, m_fillCharacter );
+				}
+			}
+		}
+
+		tileRow.resize( newTileColsCount, nullptr );
+	}
+
+	m_X_AxisLen = { new_X_AxisLen };
+}
+
+template <class Allocator>
+void TiledStorage<Allocator>::setFillCharacter( const char fillCharacter )
+{
+	for ( const tile_row& tileRow : m_tileRows )
+	{
+		for ( Tile* const tile : tileRow )
+		{
+			if ( tile != nullptr ) { std::ranges::replace( tile->cells, m_fillCharacter, fillCharacter ); }
+		}
+	}
+
+	m_fillCharacter = { fillCharacter };
+}
+
+template <class Allocator>
+void TiledStorage<Allocator>::draw( std::ostream& output_stream ) const
+{
+	if ( empty( ) ) { return; }
+
+	// every row is assembled in one buffer and written with a single call;
+	// rows that have no tiles at all share a prebuilt row of fill characters
+	const std::size_t rowLen { m_X_AxisLen };
+
+	std::string fillRow( rowLen, m_fillCharacter );
+	fillRow.back( ) = '\n';
+
+	std::string row { fillRow };
+
+	for ( std::size_t Y_Axis { }; Y_Axis < m_Y_AxisLen; ++Y_Axis )
+	{
+		const tile_row& tileRow { m_tileRows[ Y_Axis >> tile_edge_shift ] };
+
+		if ( tileRow.empty( ) )
+		{
+			output_stream.write( fillRow.data( ), static_cast<std::streamsize>( rowLen ) );
+			continue;
+		}
+
+		const std::size_t rowOffsetInTile { ( Y_Axis & ( tile_edge_len - 1 ) ) << tile_edge_shift };
+
+		for ( std::size_t tileColIdx { }; tileColIdx < tileRow.size( ); ++tileColIdx )
+		{
+			const std::size_t X_Axis { tileColIdx << tile_edge_shift };
+			const std::size_t segmentLen { std::min( tile_edge_len, rowLen - 1 - std::min( X_Axis, rowLen - 1 ) ) };
+
+			if ( const Tile* const tile { tileRow[ tileColIdx ] }; tile != nullptr )
+			{
+				std::copy_n( tile->cells.begin( ) + static_cast<std::ptrdiff_t>( rowOffsetInTile ), segmentLen,
+							 row.begin( ) + static_cast<std::ptrdiff_t>( X_Axis ) );
+			}
+			else
+			{
+				std::fill_n( row.begin( ) + static_cast<std::ptrdiff_t>( X_Axis ), segmentLen, m_fillCharacter );
+			}
+		}
+
+		output_stream.write( row.data( ), static_cast<std::streamsize>( rowLen ) );
+	}
+}
+
+template <class Allocator>
+void TiledStorage<Allocator>::draw( util::FdOutput& output ) const
+{
+	if ( empty( ) ) { return; }
+
+	// fill segments are taken from the same offset of a prebuilt fill row, so a
+	// run of missing tiles and the newline after it merge into a single chunk
+	const std::size_t rowLen { m_X_AxisLen };
+
+	std::string fillRow( rowLen, m_fillCharacter );
+	fillRow.back( ) = '\n';
+
+	for ( std::size_t Y_Axis { }; Y_Axis < m_Y_AxisLen; ++Y_Axis )
+	{
+		const tile_row& tileRow { m_tileRows[ Y_Axis >> tile_edge_shift ] };
+
+		if ( tileRow.empty( ) )
+		{
+			output.append( fillRow );
+			continue;
+		}
+
+		const std::size_t rowOffsetInTile { ( Y_Axis & ( tile_edge_len - 1 ) ) << tile_edge_shift };
+
+		for ( std::size_t tileColIdx { }; tileColIdx < tileRow.size( ); ++tileColIdx )
+		{
+			const std::size_t X_Axis { tileColIdx << tile_edge_shift };
+			const std::size_t segmentLen { std::min( tile_edge_len, rowLen - 1 - std::min( X_Axis, rowLen - 1 ) ) };
+
+			if ( const Tile* const tile { tileRow[ tileColIdx ] }; tile != nullptr )
+			{
+				output.append( { tile->cells.data( ) + rowOffsetInTile, segmentLen } );
+			}
+			else
+			{
+				output.append( { fillRow.data( ) + X_Axis, segmentLen } );
+			}
+		}
+
+		output.append( { fillRow.data( ) + rowLen - 1, 1 } );
+	}
+
+	output.flush( );
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline constexpr std::size_t
+TiledStorage<Allocator>::tiles_count_for( const std::uint32_t axisLen ) noexcept
+{
+	return ( std::size_t { axisLen } + tile_edge_len - 1 ) >> tile_edge_shift;
+}
+
+template <class Allocator>
+[[ nodiscard ]] typename TiledStorage<Allocator>::Tile*
+TiledStorage<Allocator>::allocateTile( )
+{
+	Tile* const tile { tile_alloc_traits::allocate( m_tileAllocator, 1 ) };
+	::new ( static_cast<void*>( tile ) ) Tile;
+	tile->cells.fill( m_fillCharacter );
+
+	return tile;
+}
+
+template <class Allocator>
+inline void TiledStorage<Allocator>::deallocateTile( Tile* const tile ) noexcept
+{
+	if ( tile == nullptr ) { return; }
+
+	tile_alloc_traits::deallocate( m_tileAllocator, tile, 1 );
+}
+
+template <class Allocator>
+void TiledStorage<Allocator>::releaseTiles( ) noexcept
+{
+	for ( const tile_row& tileRow : m_tileRows )
+	{
+		for ( Tile* const tile : tileRow ) { deallocateTile( tile ); }
+	}
+
+	m_tileRows.clear( );
+	m_allocatedTilesCounts.clear( );
+}
+
+template <class Allocator>
+void TiledStorage<Allocator>::stealOrCopyTiles( TiledStorage<Allocator>& rhs )
+{
+	// tiles can only change hands when they were allocated from an equal allocator,
+	// otherwise they are copied into this allocator and given back to the other one
+	if constexpr ( tile_alloc_traits::propagate_on_container_move_assignment::value )
+	{
+		m_tileAllocator = rhs.m_tileAllocator;
+	}
+
+	if ( tile_alloc_traits::propagate_on_container_move_assignment::value ||
+		 m_tileAllocator == rhs.m_tileAllocator )
+	{
+		m_tileRows = std::move( rhs.m_tileRows );
+		m_allocatedTilesCounts = std::move( rhs.m_allocatedTilesCounts );
+	}
+	else
+	{
+		m_tileRows.resize( rhs.m_tileRows.size( ) );
+		m_allocatedTilesCounts = rhs.m_allocatedTilesCounts;
+
+		for ( std::size_t tileRowIdx { }; tileRowIdx < rhs.m_tileRows.size( ); ++tileRowIdx )
+		{
+			const tile_row& source_tileRow { rhs.m_tileRows[ tileRowIdx ] };
+			tile_row& tileRow { m_tileRows[ tileRowIdx ] };
+			tileRow.assign( source_tileRow.size( ), nullptr );
+
+			for ( std::size_t tileColIdx { }; tileColIdx < source_tileRow.size( ); ++tileColIdx )
+			{
+				if ( source_tileRow[ tileColIdx ] == nullptr ) { continue; }
+
+				tileRow[ tileColIdx ] = allocateTile( );
+				tileRow[ tileColIdx ]->cells = source_tileRow[ tileColIdx ]->cells;
+			}
+		}
+
+		rhs.releaseTiles( );
+	}
+
+	rhs.m_tileRows.clear( );
+	rhs.m_allocatedTilesCounts.clear( );
+}
+
+template <class Allocator>
+inline SparseStorage<Allocator>::SparseStorage( const std::uint32_t Y_AxisLen, const std::uint32_t X_AxisLen,
+												const char fillCharacter, const Allocator& alloc )
+
+	: m_Y_AxisLen( Y_AxisLen ), m_X_AxisLen( X_AxisLen ), m_fillCharacter( fillCharacter ),
+	  m_rows( alloc )
+{
+}
+
+template <class Allocator>
+inline SparseStorage<Allocator>::SparseStorage( SparseStorage<Allocator>&& rhs ) noexcept
+
+	: m_Y_AxisLen( rhs.m_Y_AxisLen ), m_X_AxisLen( rhs.m_X_AxisLen ), m_fillCharacter( rhs.m_fillCharacter ),
+	  m_rows( std::move( rhs.m_rows ) )
+{
+	rhs.m_rows.clear( );
+	rhs.m_Y_AxisLen = 0;
+	rhs.m_X_AxisLen = 0;
+	rhs.m_fillCharacter = 0;
+}
+
+template <class Allocator>
+inline SparseStorage<Allocator>& SparseStorage<Allocator>::operator=( SparseStorage<Allocator>&& rhs ) noexcept
+{
+	if ( this != &rhs )
+	{
+		m_rows = std::move( rhs.m_rows );
+		m_Y_AxisLen = rhs.m_Y_AxisLen;
+		m_X_AxisLen = rhs.m_X_AxisLen;
+		m_fillCharacter = rhs.m_fillCharacter;
+
+		rhs.m_rows.clear( );
+		rhs.m_Y_AxisLen = 0;
+		rhs.m_X_AxisLen = 0;
+		rhs.m_fillCharacter = 0;
+	}
+
+	return *this;
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline bool SparseStorage<Allocator>::empty( ) const noexcept
+{
+	return m_Y_AxisLen == 0;
+}
+
+template <class Allocator>
+[[ nodiscard ]] char&
+SparseStorage<Allocator>::at( const std::size_t X_Axis, const std::size_t Y_Axis )
+{
+	// a cell that is not there yet gets inserted holding the fill character; the
+	// returned reference stays valid until the next cell is inserted
+	const auto row_iter { std::ranges::lower_bound( m_rows, Y_Axis, { }, &Row::Y_Axis ) };
+
+	Row& row { ( row_iter != m_rows.end( ) && row_iter->Y_Axis == Y_Axis ) ? *row_iter :
+			   *m_rows.insert( row_iter, Row { static_cast<std::uint32_t>( Y_Axis ),
+											   cell_row( m_rows.get_allocator( ) ) } ) };
+
+	const auto cell_iter { std::ranges::lower_bound( row.cells, X_Axis, { }, &Cell::X_Axis ) };
+
+	if ( cell_iter != row.cells.end( ) && cell_iter->X_Axis == X_Axis ) [[ likely ]]
+	{
+		return cell_iter->ch;
+	}
+
+	return row.cells.insert( cell_iter, Cell { static_cast<std::uint32_t>( X_Axis ), m_fillCharacter } )->ch;
+}
+
+template <class Allocator>
+[[ nodiscard ]] const char&
+SparseStorage<Allocator>::at( const std::size_t X_Axis, const std::size_t Y_Axis ) const noexcept
+{
+	const auto row_iter { std::ranges::lower_bound( m_rows, Y_Axis, { }, &Row::Y_Axis ) };
+
+	if ( row_iter == m_rows.end( ) || row_iter->Y_Axis != Y_Axis ) { return m_fillCharacter; }
+
+	const auto cell_iter { std::ranges::lower_bound( row_iter->cells, X_Axis, { }, &Cell::X_Axis ) };
+
+	if ( cell_iter == row_iter->cells.end( ) || cell_iter->X_Axis != X_Axis ) { return m_fillCharacter; }
+
+	return cell_iter->ch;
+}
+
+template <class Allocator>
+[[ nodiscard ]] std::size_t
+SparseStorage<Allocator>::getOccupiedCellsCount( ) const noexcept
+{
+	std::size_t occupiedCellsCount { };
+
+	for ( const Row& row : m_rows ) { occupiedCellsCount += row.cells.size( ); }
+
+	return occupiedCellsCount;
+}
+
+template <class Allocator>
+void SparseStorage<Allocator>::setY_AxisLen( const std::uint32_t Y_AxisLen )
+{
+	const std::uint32_t& new_Y_AxisLen { Y_AxisLen };
+
+	m_rows.erase( std::ranges::lower_bound( m_rows, new_Y_AxisLen, { }, &Row::Y_Axis ), m_rows.end( ) );
+
+	m_Y_AxisLen = { new_Y_AxisLen };
+}
+
+template <class Allocator>
+void SparseStorage<Allocator>::setX_AxisLen( const std::uint32_t X_AxisLen )
+{
+	const std::uint32_t& new_X_AxisLen { X_AxisLen };
+
+	// the last column is where the newline goes, so the cut-off part starts there
+	for ( Row& row : m_rows )
+	{
+		row.cells.erase( std::ranges::lower_bound( row.cells, new_X_AxisLen - 1, { }, &Cell::X_Axis ),
+						 row.cells.end( ) );
+	}
+
+	std::erase_if( m_rows, [ ]( const Row& row ) noexcept { return row.cells.empty( ); } );
+
+	m_X_AxisLen = { new_X_AxisLen };
+}
+
+template <class Allocator>
+void SparseStorage<Allocator>::setFillCharacter( const char fillCharacter )
+{
+	// cells that hold the old fill character become indistinguishable from the
+	// ones that were never written to, so they are dropped instead of rewritten
+	for ( Row& row : m_rows )
+	{
+		std::erase_if( row.cells, [ this ]( const Cell& cell ) noexcept { return cell.ch == m_fillCharacter; } );
+	}
+
+	std::erase_if( m_rows, [ ]( const Row& row ) noexcept { return row.cells.empty( ); } );
+
+	m_fillCharacter = { fillCharacter };
+}
+
+template <class Allocator>
+void SparseStorage<Allocator>::draw( std::ostream& output_stream ) const
+{
+	if ( empty( ) ) { return; }
+
+	const std::size_t rowLen { m_X_AxisLen };
+
+	std::string fillRow( rowLen, m_fillCharacter );
+	fillRow.back( ) = '\n';
+
+	std::string row { fillRow };
+
+	auto row_iter { m_rows.begin( ) };
+
+	for ( std::uint32_t Y_Axis { }; Y_Axis < m_Y_AxisLen; ++Y_Axis )
+	{
+		if ( row_iter == m_rows.end( ) || row_iter->Y_Axis != Y_Axis )
+		{
+			output_stream.write( fillRow.data( ), static_cast<std::streamsize>( rowLen ) );
+			continue;
+		}
+
+		for ( const Cell& cell : row_iter->cells ) { row[ cell.X_Axis ] = cell.ch; }
+
+		output_stream.write( row.data( ), static_cast<std::streamsize>( rowLen ) );
+
+		for ( const Cell& cell : row_iter->cells ) { row[ cell.X_Axis ] = m_fillCharacter; }
+
+		++row_iter;
+	}
+}
+
+template <class Allocator>
+void SparseStorage<Allocator>::draw( util::FdOutput& output ) const
+{
+	if ( empty( ) ) { return; }
+
+	// empty rows all point at one fill row; the occupied ones have to be built,
+	// in a buffer that is flushed before it would have to grow and move
+	const std::size_t rowLen { m_X_AxisLen };
+	const std::size_t bufferCapacity { std::max( rowLen, util::LineReader::default_block_size ) };
+
+	std::string fillRow( rowLen, m_fillCharacter );
+	fillRow.back( ) = '\n';
+
+	std::string rowsBuffer;
+	rowsBuffer.reserve( bufferCapacity );
+
+	auto row_iter { m_rows.begin( ) };
+
+	for ( std::uint32_t Y_Axis { }; Y_Axis < m_Y_AxisLen; ++Y_Axis )
+	{
+		if ( row_iter == m_rows.end( ) || row_iter->Y_Axis != Y_Axis )
+		{
+			output.append( fillRow );
+			continue;
+		}
+
+		if ( rowsBuffer.size( ) + rowLen > bufferCapacity )
+		{
+			output.flush( );
+			rowsBuffer.clear( );
+		}
+
+		const std::size_t rowStart { rowsBuffer.size( ) };
+		rowsBuffer += fillRow;
+
+		for ( const Cell& cell : row_iter->cells ) { rowsBuffer[ rowStart + cell.X_Axis ] = cell.ch; }
+
+		output.append( { rowsBuffer.data( ) + rowStart, rowLen } );
+
+		++row_iter;
+	}
+
+	output.flush( );
+}
+
+
+template <class Allocator>
+inline StridedStorage<Allocator>::StridedStorage( const std::uint32_t Y_AxisLen, const std::uint32_t X_AxisLen,
+												  const char fillCharacter, const Allocator& alloc )
+
+	: m_Y_AxisLen( Y_AxisLen ), m_X_AxisLen( X_AxisLen ), m_fillCharacter( fillCharacter ),
+	  m_rowStride( row_stride_for( X_AxisLen ) ), m_firstRowOffset( 0 ),
+	  m_buffer( std::size_t { Y_AxisLen } * m_rowStride + row_alignment - 1, fillCharacter, alloc )
+{
+	m_firstRowOffset = aligned_offset_of( m_buffer.data( ) );
+}
+
+template <class Allocator>
+inline StridedStorage<Allocator>::StridedStorage( StridedStorage<Allocator>&& rhs ) noexcept
+
+	: m_Y_AxisLen( rhs.m_Y_AxisLen ), m_X_AxisLen( rhs.m_X_AxisLen ), m_fillCharacter( rhs.m_fillCharacter ),
+	  m_rowStride( rhs.m_rowStride ), m_firstRowOffset( rhs.m_firstRowOffset ), m_buffer( std::move( rhs.m_buffer ) )
+{
+	rhs.m_buffer.clear( );
+	rhs.m_Y_AxisLen = 0;
+	rhs.m_X_AxisLen = 0;
+	rhs.m_fillCharacter = 0;
+}
+
+template <class Allocator>
+inline StridedStorage<Allocator>& StridedStorage<Allocator>::operator=( StridedStorage<Allocator>&& rhs ) noexcept
+{
+	if ( this != &rhs )
+	{
+		// allocators that do not compare equal copy the buffer instead of
+		// stealing it, and the copy may start at a different alignment
+		m_buffer = std::move( rhs.m_buffer );
+		m_Y_AxisLen = rhs.m_Y_AxisLen;
+		m_X_AxisLen = rhs.m_X_AxisLen;
+		m_fillCharacter = rhs.m_fillCharacter;
+		m_rowStride = rhs.m_rowStride;
+		m_firstRowOffset = rhs.m_firstRowOffset;
+		realignRows( rhs.m_firstRowOffset, m_buffer.empty( ) ? 0 : m_Y_AxisLen * m_rowStride );
+
+		rhs.m_buffer.clear( );
+		rhs.m_Y_AxisLen = 0;
+		rhs.m_X_AxisLen = 0;
+		rhs.m_fillCharacter = 0;
+	}
+
+	return *this;
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline bool StridedStorage<Allocator>::empty( ) const noexcept
+{
+	return m_buffer.empty( );
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline Allocator StridedStorage<Allocator>::get_allocator( ) const noexcept
+{
+	return m_buffer.get_allocator( );
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline char&
+StridedStorage<Allocator>::at( const std::size_t X_Axis, const std::size_t Y_Axis ) noexcept
+{
+	return m_buffer[ m_firstRowOffset + Y_Axis * m_rowStride + X_Axis ];
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline const char&
+StridedStorage<Allocator>::at( const std::size_t X_Axis, const std::size_t Y_Axis ) const noexcept
+{
+	return m_buffer[ m_firstRowOffset + Y_Axis * m_rowStride + X_Axis ];
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline std::size_t StridedStorage<Allocator>::getRowStride( ) const noexcept
+{
+	return m_rowStride;
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline std::string_view StridedStorage<Allocator>::getRows( ) const noexcept
+{
+	if ( empty( ) ) { return { }; }
+
+	return { m_buffer.data( ) + m_firstRowOffset, m_Y_AxisLen * m_rowStride };
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline constexpr std::size_t
+StridedStorage<Allocator>::row_stride_for( const std::uint32_t X_AxisLen ) noexcept
+{
+	const std::size_t cellsCount { std::max<std::size_t>( X_AxisLen, 2 ) - 1 };
+
+	return ( cellsCount + row_alignment - 1 ) / row_alignment * row_alignment;
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline std::size_t StridedStorage<Allocator>::aligned_offset_of( const char* const address ) noexcept
+{
+	return ( row_alignment - reinterpret_cast<std::uintptr_t>( address ) % row_alignment ) % row_alignment;
+}
+
+template <class Allocator>
+inline void StridedStorage<Allocator>::realignRows( const std::size_t previousFirstRowOffset,
+													const std::size_t rowsSize ) noexcept
+{
+	if ( m_buffer.empty( ) ) { return; }
+
+	m_firstRowOffset = aligned_offset_of( m_buffer.data( ) );
+
+	if ( m_firstRowOffset != previousFirstRowOffset )
+	{
+		std::memmove( m_buffer.data( ) + m_firstRowOffset, m_buffer.data( ) + previousFirstRowOffset, rowsSize );
+	}
+}
+
+template <class Allocator>
+void StridedStorage<Allocator>::setY_AxisLen( const std::uint32_t Y_AxisLen )
+{
+	if ( Y_AxisLen == m_Y_AxisLen ) { return; }
+
+	const std::size_t keptRowsSize { std::min( Y_AxisLen, m_Y_AxisLen ) * m_rowStride };
+	const std::size_t previousFirstRowOffset { m_firstRowOffset };
+
+	m_buffer.resize( Y_AxisLen * m_rowStride + row_alignment - 1, m_fillCharacter );
+	realignRows( previousFirstRowOffset, keptRowsSize );
+
+	// whatever follows the kept rows may hold cells that were moved or cut off
+	std::fill( m_buffer.begin( ) + static_cast<std::ptrdiff_t>( m_firstRowOffset + keptRowsSize ),
+			   m_buffer.end( ), m_fillCharacter );
+
+	m_Y_AxisLen = { Y_AxisLen };
+}
+
+template <class Allocator>
+void StridedStorage<Allocator>::setX_AxisLen( const std::uint32_t X_AxisLen )
+{
+	if ( X_AxisLen == m_X_AxisLen ) { return; }
+
+	const std::size_t new_rowStride { row_stride_for( X_AxisLen ) };
+
+	if ( new_rowStride == m_rowStride )
+	{
+		// a wider row finds fill characters in its padding already, a narrower
+		// one puts them back into the columns it cuts off
+		if ( X_AxisLen < m_X_AxisLen )
+		{
+			for ( std::size_t Y_Axis { }; Y_Axis < m_Y_AxisLen; ++Y_Axis )
+			{
+				std::fill_n( &at( X_AxisLen - 1, Y_Axis ), m_X_AxisLen - X_AxisLen, m_fillCharacter );
+			}
+		}
+	}
+	else
+	{
+		std::vector<char, Allocator> buffer( m_Y_AxisLen * new_rowStride + row_alignment - 1, m_fillCharacter,
+											 m_buffer.get_allocator( ) );
+		const std::size_t firstRowOffset { aligned_offset_of( buffer.data( ) ) };
+		const std::size_t keptCellsCount { std::min( X_AxisLen, m_X_AxisLen ) - std::size_t { 1 } };
+
+		for ( std::size_t Y_Axis { }; Y_Axis < m_Y_AxisLen; ++Y_Axis )
+		{
+			std::copy_n( &at( 0, Y_Axis ), keptCellsCount, buffer.data( ) + firstRowOffset + Y_Axis * new_rowStride );
+		}
+
+		m_buffer = std::move( buffer );
+		m_firstRowOffset = firstRowOffset;
+		m_rowStride = new_rowStride;
+	}
+
+	m_X_AxisLen = { X_AxisLen };
+}
+
+template <class Allocator>
+void StridedStorage<Allocator>::setFillCharacter( const char fillCharacter )
+{
+	std::ranges::replace( m_buffer, m_fillCharacter, fillCharacter );
+
+	m_fillCharacter = { fillCharacter };
+}
+
+template <class Allocator>
+void StridedStorage<Allocator>::draw( std::ostream& output_stream ) const
+{
+	for ( std::size_t Y_Axis { }; Y_Axis < m_Y_AxisLen; ++Y_Axis )
+	{
+		output_stream.write( &at( 0, Y_Axis ), static_cast<std::streamsize>( m_X_AxisLen - 1 ) );
+		output_stream.put( '\n' );
+	}
+}
+
+template <class Allocator>
+void StridedStorage<Allocator>::draw( util::FdOutput& output ) const
+{
+	static constexpr char newline { '\n' };
+
+	for ( std::size_t Y_Axis { }; Y_Axis < m_Y_AxisLen; ++Y_Axis )
+	{
+		output.append( { &at( 0, Y_Axis ), m_X_AxisLen - std::size_t { 1 } } );
+		output.append( { &newline, 1 } );
+	}
+
+	output.flush( );
+}
+
+
+template <class Allocator>
+inline PackedStorage<Allocator>::reference::reference( PackedStorage& storage, unsigned char& packedCells,
+													   const unsigned shift ) noexcept
+
+	: m_storage( &storage ), m_packedCells( &packedCells ), m_shift( shift )
+{
+}
+
+template <class Allocator>
+inline typename PackedStorage<Allocator>::reference&
+PackedStorage<Allocator>::reference::operator=( const char ch )
+{
+	const unsigned char code { m_storage->getCode( ch ) };
+
+	*m_packedCells = static_cast<unsigned char>( ( *m_packedCells & ~( 0x0Fu << m_shift ) ) | ( code << m_shift ) );
+
+	return *this;
+}
+
+template <class Allocator>
+inline typename PackedStorage<Allocator>::reference&
+PackedStorage<Allocator>::reference::operator=( const reference& rhs )
+{
+	return *this = static_cast<char>( rhs );
+}
+
+template <class Allocator>
+inline PackedStorage<Allocator>::reference::operator char( ) const noexcept
+{
+	return m_storage->m_palette[ ( *m_packedCells >> m_shift ) & 0x0F ];
+}
+
+template <class Allocator>
+inline PackedStorage<Allocator>::PackedStorage( const std::uint32_t Y_AxisLen, const std::uint32_t X_AxisLen,
+												const char fillCharacter, const Allocator& alloc )
+
+	: m_Y_AxisLen( Y_AxisLen ), m_X_AxisLen( X_AxisLen ), m_fillCharacter( fillCharacter ),
+	  m_rowSize( row_size_for( X_AxisLen ) ), m_paletteLen( 1 + line_characters.size( ) ), m_palette( ), m_codes( ),
+	  m_packedCells( std::size_t { Y_AxisLen } * m_rowSize, 0, alloc )
+{
+	m_codes.fill( no_code );
+
+	for ( std::size_t code { 1 }; const char ch : line_characters )
+	{
+		m_palette[ code ] = ch;
+		m_codes[ static_cast<unsigned char>( ch ) ] = static_cast<unsigned char>( code++ );
+	}
+
+	m_palette[ 0 ] = fillCharacter;
+	m_codes[ static_cast<unsigned char>( fillCharacter ) ] = 0;
+}
+
+template <class Allocator>
+inline PackedStorage<Allocator>::PackedStorage( PackedStorage<Allocator>&& rhs ) noexcept
+
+	: m_Y_AxisLen( rhs.m_Y_AxisLen ), m_X_AxisLen( rhs.m_X_AxisLen ), m_fillCharacter( rhs.m_fillCharacter ),
+	  m_rowSize( rhs.m_rowSize ), m_paletteLen( rhs.m_paletteLen ), m_palette( rhs.m_palette ),
+	  m_codes( rhs.m_codes ), m_packedCells( std::move( rhs.m_packedCells ) )
+{
+	rhs.m_packedCells.clear( );
+	rhs.m_Y_AxisLen = 0;
+	rhs.m_X_AxisLen = 0;
+	rhs.m_fillCharacter = 0;
+}
+
+template <class Allocator>
+inline PackedStorage<Allocator>& PackedStorage<Allocator>::operator=( PackedStorage<Allocator>&& rhs ) noexcept
+{
+	if ( this != &rhs )
+	{
+		m_packedCells = std::move( rhs.m_packedCells );
+		m_Y_AxisLen = rhs.m_Y_AxisLen;
+		m_X_AxisLen = rhs.m_X_AxisLen;
+		m_fillCharacter = rhs.m_fillCharacter;
+		m_rowSize = rhs.m_rowSize;
+		m_paletteLen = rhs.m_paletteLen;
+		m_palette = rhs.m_palette;
+		m_codes = rhs.m_codes;
+
+		rhs.m_packedCells.clear( );
+		rhs.m_Y_AxisLen = 0;
+		rhs.m_X_AxisLen = 0;
+		rhs.m_fillCharacter = 0;
+	}
+
+	return *this;
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline bool PackedStorage<Allocator>::empty( ) const noexcept
+{
+	return m_packedCells.empty( );
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline Allocator PackedStorage<Allocator>::get_allocator( ) const noexcept
+{
+	return Allocator { m_packedCells.get_allocator( ) };
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline typename PackedStorage<Allocator>::reference
+PackedStorage<Allocator>::at( const std::size_t X_Axis, const std::size_t Y_Axis ) noexcept
+{
+	return { *this, m_packedCells[ Y_Axis * m_rowSize + X_Axis / 2 ], static_cast<unsigned>( X_Axis % 2 * 4 ) };
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline char
+PackedStorage<Allocator>::at( const std::size_t X_Axis, const std::size_t Y_Axis ) const noexcept
+{
+	return m_palette[ ( m_packedCells[ Y_Axis * m_rowSize + X_Axis / 2 ] >> ( X_Axis % 2 * 4 ) ) & 0x0F ];
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline std::size_t PackedStorage<Allocator>::getPackedSize( ) const noexcept
+{
+	return m_packedCells.size( );
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline constexpr std::size_t
+PackedStorage<Allocator>::row_size_for( const std::uint32_t X_AxisLen ) noexcept
+{
+	return std::max<std::size_t>( X_AxisLen, 2 ) / 2;
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline unsigned char PackedStorage<Allocator>::getCode( const char ch )
+{
+	unsigned char& code { m_codes[ static_cast<unsigned char>( ch ) ] };
+
+	if ( code != no_code ) { return code; }
+
+	if ( m_paletteLen == palette_size )
+	{
+		throw std::invalid_argument( "Packed_Storage_Exception: A packed canvas can not hold more than " +
+									 std::to_string( palette_size ) + " distinct characters" );
+	}
+
+	m_palette[ m_paletteLen ] = ch;
+	code = static_cast<unsigned char>( m_paletteLen++ );
+
+	return code;
+}
+
+template <class Allocator>
+[[ nodiscard ]] inline constexpr unsigned char PackedStorage<Allocator>::reserved_code_of( const char ch ) noexcept
+{
+	const auto line_character_iter { std::ranges::find( line_characters, ch ) };
+
+	return line_character_iter == line_characters.end( ) ? no_code :
+		   static_cast<unsigned char>( 1 + ( line_character_iter - line_characters.begin( ) ) );
+}
+
+template <class Allocator>
+void PackedStorage<Allocator>::recodeCells( const unsigned char fromCode, const unsigned char toCode ) noexcept
+{
+	for ( unsigned char& packedCells : m_packedCells )
+	{
+		const unsigned lowCode { packedCells & 0x0Fu };
+		const unsigned highCode { unsigned { packedCells } >> 4 };
+
+		packedCells = static_cast<unsigned char>( ( lowCode == fromCode ? toCode : lowCode ) |
+												  ( highCode == fromCode ? toCode : highCode ) << 4 );
+	}
+}
+
+template <class Allocator>
+void PackedStorage<Allocator>::releaseCode( const unsigned char code ) noexcept
+{
+	// the codes of the line characters are never handed out again
+	if ( code <= line_characters.size( ) ) { return; }
+
+	const auto lastCode { static_cast<unsigned char>( --m_paletteLen ) };
+
+	if ( code != lastCode )
+	{
+		recodeCells( lastCode, code );
+		m_palette[ code ] = m_palette[ lastCode ];
+		m_codes[ static_cast<unsigned char>( m_palette[ code ] ) ] = code;
+	}
+}
+
+template <class Allocator>
+inline void PackedStorage<Allocator>::expandRow( const std::size_t Y_Axis, char* const expandedRow_OUT ) const noexcept
+{
+	util::expand_nibbles( m_packedCells.data( ) + Y_Axis * m_rowSize, m_X_AxisLen - std::size_t { 1 }, m_palette,
+						  expandedRow_OUT );
+	expandedRow_OUT[ m_X_AxisLen - 1 ] = '\n';
+}
+
+template <class Allocator>
+void PackedStorage<Allocator>::setY_AxisLen( const std::uint32_t Y_AxisLen )
+{
+	m_packedCells.resize( std::size_t { Y_AxisLen } * m_rowSize, 0 );
+
+	m_Y_AxisLen = { Y_AxisLen };
+}
+
+template <class Allocator>
+void PackedStorage<Allocator>::setX_AxisLen( const std::uint32_t X_AxisLen )
+{
+	if ( X_AxisLen == m_X_AxisLen ) { return; }
+
+	const std::size_t new_rowSize { row_size_for( X_AxisLen ) };
+	const std::size_t keptCellsCount { std::min( X_AxisLen, m_X_AxisLen ) - std::size_t { 1 } };
+	const std::size_t keptBytesCount { ( keptCellsCount + 1 ) / 2 };
+
+	packed_cells_type packedCells( m_Y_AxisLen * new_rowSize, 0, m_packedCells.get_allocator( ) );
+
+	for ( std::size_t Y_Axis { }; Y_Axis < m_Y_AxisLen; ++Y_Axis )
+	{
+		unsigned char* const row { packedCells.data( ) + Y_Axis * new_rowSize };
+
+		std::copy_n( m_packedCells.data( ) + Y_Axis * m_rowSize, keptBytesCount, row );
+
+		// the other half of the last byte belongs to a cell that was cut off
+		if ( keptCellsCount % 2 != 0 ) { row[ keptBytesCount - 1 ] &= 0x0F; }
+	}
+
+	m_packedCells = std::move( packedCells );
+	m_rowSize = new_rowSize;
+	m_X_AxisLen = { X_AxisLen };
+}
+
+template <class Allocator>
+void PackedStorage<Allocator>::setFillCharacter( const char fillCharacter )
+{
+	// the cells keep their codes, only what code 0 stands for changes; cells that
+	// held the new fill character under a code of their own become code 0 too,
+	// as a dense canvas can not tell them from the fill either, and free that code
+	const unsigned char foldedCode { m_codes[ static_cast<unsigned char>( fillCharacter ) ] };
+
+	if ( foldedCode != 0 && foldedCode != no_code )
+	{
+		recodeCells( foldedCode, 0 );
+		releaseCode( foldedCode );
+	}
+
+	m_codes[ static_cast<unsigned char>( m_fillCharacter ) ] = reserved_code_of( m_fillCharacter );
+	m_palette[ 0 ] = fillCharacter;
+	m_codes[ static_cast<unsigned char>( fillCharacter ) ] = 0;
+
+	m_fillCharacter = { fillCharacter };
+}
+
+template <class Allocator>
+void PackedStorage<Allocator>::draw( std::ostream& output_stream ) const
+{
+	if ( empty( ) ) { return; }
+
+	std::string row( m_X_AxisLen, '\n' );
+
+	for ( std::size_t Y_Axis { }; Y_Axis < m_Y_AxisLen; ++Y_Axis )
+	{
+		expandRow( Y_Axis, row.data( ) );
+		output_stream.write( row.data( ), static_cast<std::streamsize>( row.size( ) ) );
+	}
+}
+
+template <class Allocator>
+void PackedStorage<Allocator>::draw( util::FdOutput& output ) const
+{
+	if ( empty( ) ) { return; }
+
+	// rows are expanded into one buffer that is flushed before it would overflow
+	const std::size_t rowLen { m_X_AxisLen };
+	const std::size_t rowsPerBuffer { std::max<std::size_t>( util::LineReader::default_block_size / rowLen, 1 ) };
+
+	std::string rowsBuffer( rowsPerBuffer * rowLen, '\n' );
+
+	for ( std::size_t Y_Axis { }; Y_Axis < m_Y_AxisLen; ++Y_Axis )
+	{
+		const std::size_t rowIdxInBuffer { Y_Axis % rowsPerBuffer };
+
+		if ( rowIdxInBuffer == 0 && Y_Axis != 0 ) { output.flush( ); }
+
+		expandRow( Y_Axis, rowsBuffer.data( ) + rowIdxInBuffer * rowLen );
+		output.append( { rowsBuffer.data( ) + rowIdxInBuffer * rowLen, rowLen } );
+	}
+
+	output.flush( );
+}
+
+}
@@ -0,0 +1,283 @@
+// PeykNowruzi - Basic ASCII-Art Generator
+// Copyright (C) 2021-2022 Kasra Hashemi
+
+/*
+
+ This file is part of PeykNowruzi.
+
+ PeykNowruzi is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License,
+ or (at your option) any later version.
+
+ PeykNowruzi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty
+ of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with PeykNowruzi. If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+
+// Applies the same short random sequences of edits to a dense CharMatrix and to
+// one of every other storage policy and compares what they draw and their
+// content hashes after each edit, e.g.
+//   PeykNowruziStorageCheck --sequences=100000 --seed=7
+// The first sequence that leaves a policy different from the dense canvas is
+// written to the standard error and fails the check.
+
+
+#include "CharMatrix.hpp"
+#include "Util.hpp"
+#include "pch.hpp"
+
+
+namespace peyknowruzi::storage_check
+{
+
+struct CheckSettings
+{
+	std::uint64_t seed { 1 };
+	std::size_t sequencesCount { 20'000 };
+};
+
+// small canvases, so that edits keep landing on cells that were edited before
+inline constexpr std::uint32_t max_y_axis_len { 8 };
+inline constexpr std::uint32_t max_x_axis_len { 12 };
+inline constexpr std::size_t max_edits_per_sequence { 16 };
+
+// the fill characters also get written as ordinary cells, which is what makes a
+// later setFillCharacter( ) meet cells that already hold the new fill character
+inline constexpr std::array<char, 4> fill_characters { ' ', '.', 'a', 'b' };
+inline constexpr std::uint32_t fill_characters_count { static_cast<std::uint32_t>( fill_characters.size( ) ) };
+inline constexpr std::array<char, 8> cell_characters { ' ', '.', 'a', 'b', '-', '\\', '/', '|' };
+
+enum class Edit_Kind : std::uint32_t
+{
+	write_cell,
+	draw_coords,
+	set_fill_character,
+	set_y_axis_len,
+	set_x_axis_len,
+};
+
+inline constexpr std::uint32_t edit_kinds_count { std::to_underlying( Edit_Kind::set_x_axis_len ) + 1 };
+
+struct Edit
+{
+	Edit_Kind kind;
+	std::array<std::uint32_t, 4> values;
+};
+
+// splitmix64, the same sequence for the same seed on every platform
+class RandomSource
+{
+public:
+	explicit RandomSource( const std::uint64_t seed ) noexcept : m_state( seed ) { }
+
+	[[ nodiscard ]] std::uint64_t next( ) noexcept
+	{
+		std::uint64_t value { m_state += 0x9E3779B97F4A7C15 };
+		value = ( value ^ ( value >> 30 ) ) * 0xBF58476D1CE4E5B9;
+		value = ( value ^ ( value >> 27 ) ) * 0x94D049BB133111EB;
+		return value ^ ( value >> 31 );
+	}
+
+	// uniform enough in [ 0, bound ) for bounds this small
+	[[ nodiscard ]] std::uint32_t below( const std::uint32_t bound ) noexcept
+	{
+		return static_cast<std::uint32_t>( next( ) % bound );
+	}
+
+private:
+	std::uint64_t m_state;
+};
+
+[[ nodiscard ]] CheckSettings parse_settings( const std::span<char* const> args )
+{
+	using std::string_view_literals::operator""sv;
+
+	static constexpr std::string_view seed_option_prefix { "--seed="sv };
+	static constexpr std::string_view sequences_option_prefix { "--sequences="sv };
+
+	CheckSettings settings { };
+
+	for ( const std::string_view arg : args.subspan( std::min<std::size_t>( args.size( ), 1 ) ) )
+	{
+		if ( arg.starts_with( seed_option_prefix ) )
+		{
+			settings.seed = util::parse_option_value<std::uint64_t>( arg, seed_option_prefix );
+		}
+		else if ( arg.starts_with( sequences_option_prefix ) )
+		{
+			settings.sequencesCount = util::parse_option_value<std::size_t>( arg, sequences_option_prefix, 1 );
+		}
+		else
+		{
+			throw std::runtime_error( "Invalid_Option_Exception: Unknown option '" + std::string { arg } + "'" );
+		}
+	}
+
+	return settings;
+}
+
+// the values of an edit are picked for the largest canvas and wrapped into the
+// current one when the edit is applied, so that every policy gets the same edit
+[[ nodiscard ]] Edit make_edit( RandomSource& random_source )
+{
+	const auto kind { static_cast<Edit_Kind>( random_source.below( edit_kinds_count ) ) };
+
+	return { kind, { random_source.below( 0x10000 ), random_source.below( 0x10000 ),
+					 random_source.below( 0x10000 ), random_source.below( 0x10000 ) } };
+}
+
+template < class Matrix >
+void apply_edit( Matrix& matrix, const Edit& edit )
+{
+	const std::uint32_t Y_AxisLen { matrix.getY_AxisLen( ) };
+	const std::uint32_t cellsPerRow { matrix.getX_AxisLen( ) - 1 };
+	const auto& [ first, second, third, fourth ] { edit.values };
+
+	switch ( edit.kind )
+	{
+		case Edit_Kind::write_cell:
+			matrix[ first % cellsPerRow, second % Y_AxisLen ] = cell_characters[ third % cell_characters.size( ) ];
+			break;
+		case Edit_Kind::draw_coords:
+			matrix.setCharacterMatrix( std::array<std::uint32_t, 4> { first % cellsPerRow, second % Y_AxisLen,
+																	  third % cellsPerRow, fourth % Y_AxisLen } );
+			break;
+		case Edit_Kind::set_fill_character:
+			matrix.setFillCharacter( fill_characters[ first % fill_characters.size( ) ] );
+			break;
+		case Edit_Kind::set_y_axis_len:
+			matrix.setY_AxisLen( 1 + first % max_y_axis_len );
+			break;
+		case Edit_Kind::set_x_axis_len:
+			matrix.setX_AxisLen( 2 + first % ( max_x_axis_len - 1 ) );
+			break;
+	}
+}
+
+template < class Matrix >
+[[ nodiscard ]] std::string draw_to_string( const Matrix& matrix )
+{
+	std::ostringstream oss;
+	matrix.draw( oss );
+
+	return std::move( oss ).str( );
+}
+
+[[ nodiscard ]] std::string_view edit_kind_name( const Edit_Kind kind ) noexcept
+{
+	switch ( kind )
+	{
+		case Edit_Kind::write_cell: return "write_cell";
+		case Edit_Kind::draw_coords: return "draw_coords";
+		case Edit_Kind::set_fill_character: return "set_fill_character";
+		case Edit_Kind::set_y_axis_len: return "set_y_axis_len";
+		case Edit_Kind::set_x_axis_len: return "set_x_axis_len";
+	}
+
+	return "unknown";
+}
+
+void report_mismatch( const std::string_view policyName, const std::size_t sequenceIdx,
+					  const std::span<const Edit> edits, const std::string_view expected,
+					  const std::string_view actual )
+{
+	std::cerr << "StorageCheck_Exception: " << policyName << " differs from dense storage in sequence "
+			  << sequenceIdx << " after:\n";
+
+	for ( const Edit& edit : edits )
+	{
+		std::cerr << "  " << edit_kind_name( edit.kind ) << ' ' << edit.values[ 0 ] << ' ' << edit.values[ 1 ]
+				  << ' ' << edit.values[ 2 ] << ' ' << edit.values[ 3 ] << '\n';
+	}
+
+	std::cerr << "expected:\n" << expected << "actual:\n" << actual << '\n';
+}
+
+// replays every sequence on a dense canvas and a canvas of Storage; returns false
+// at the first edit after which the two draw differently or hash differently
+template < template < class > class Storage >
+[[ nodiscard ]] bool check_policy( const std::string_view policyName, const CheckSettings& settings )
+{
+	RandomSource random_source { settings.seed };
+	std::vector<Edit> edits;
+
+	for ( std::size_t sequenceIdx { }; sequenceIdx < settings.sequencesCount; ++sequenceIdx )
+	{
+		const std::uint32_t Y_AxisLen { 1 + random_source.below( max_y_axis_len ) };
+		const std::uint32_t X_AxisLen { 2 + random_source.below( max_x_axis_len - 1 ) };
+		const char fillCharacter { fill_characters[ random_source.below( fill_characters_count ) ] };
+
+		CharMatrix<> dense_matrix { Y_AxisLen, X_AxisLen, fillCharacter };
+		CharMatrix< std::allocator<char>, Storage > matrix { Y_AxisLen, X_AxisLen, fillCharacter };
+
+		edits.clear( );
+		const std::size_t editsCount { 1 + random_source.below( max_edits_per_sequence ) };
+
+		for ( std::size_t editIdx { }; editIdx < editsCount; ++editIdx )
+		{
+			edits.push_back( make_edit( random_source ) );
+			apply_edit( dense_matrix, edits.back( ) );
+			apply_edit( matrix, edits.back( ) );
+
+			const std::string expected { draw_to_string( dense_matrix ) };
+			const std::string actual { draw_to_string( matrix ) };
+
+			if ( expected != actual || dense_matrix.getContentHash( ) != matrix.getContentHash( ) )
+			{
+				report_mismatch( policyName, sequenceIdx, edits, expected, actual );
+				return false;
+			}
+		}
+	}
+
+	std::cerr << policyName << ": " << settings.sequencesCount << " sequences match dense storage\n";
+
+	return true;
+}
+
+[[ nodiscard ]] bool run_checks( const CheckSettings& settings )
+{
+	bool isEveryPolicyMatching { true };
+
+	isEveryPolicyMatching &= check_policy<TiledStorage>( "tiled", settings );
+	isEveryPolicyMatching &= check_policy<SparseStorage>( "sparse", settings );
+	isEveryPolicyMatching &= check_policy<StridedStorage>( "strided", settings );
+	isEveryPolicyMatching &= check_policy<PackedStorage>( "packed", settings );
+
+	return isEveryPolicyMatching;
+}
+
+}
+
+
+namespace pns = peyknowruzi::storage_check;
+
+
+int main( int argc, char* argv[] )
+{
+	const std::span<char* const> args { argv, static_cast<std::size_t>( argc ) };
+
+	try
+	{
+		const pns::CheckSettings settings { pns::parse_settings( args ) };
+
+		return pns::run_checks( settings ) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+	catch ( const std::bad_alloc& )
+	{
+		std::cerr << "Memory_Exception: Ran out of memory\n";
+		return EXIT_FAILURE;
+	}
+	catch ( const std::exception& ex )
+	{
+		std::cerr << ex.what( ) << '\n';
+		return EXIT_FAILURE;
+	}
+}
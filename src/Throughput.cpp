@@ -0,0 +1,302 @@
+
+// PeykNowruzi - Basic ASCII-Art Generator
+// Copyright (C) 2021-2022 Kasra Hashemi
+
+/*
+
+ This file is part of PeykNowruzi.
+
+ PeykNowruzi is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License,
+ or (at your option) any later version.
+
+ PeykNowruzi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty
+ of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with PeykNowruzi. If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+
+// Generates a workload in memory, pipes it through PeykNowruzi in --batch mode
+// a few times and reports the throughput of each run, e.g.
+//   PeykNowruziThroughput --binary=../build/release/PeykNowruzi --documents=100000 --binary-arg=--pipelined
+// Every run's output is compared with what the reference renderer expects, a
+// mismatch fails the run. The options of PeykNowruziGen select the workload.
+
+
+#include "Workload.hpp"
+#include "Util.hpp"
+#include "pch.hpp"
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#define PN_POSIX_IO 1
+#include <csignal>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#else
+#define PN_POSIX_IO 0
+#endif
+
+namespace peyknowruzi::throughput
+{
+
+struct HarnessSettings
+{
+	workload::WorkloadSettings workloadSettings { };
+	std::string binaryPath { "../build/release/PeykNowruzi" };
+	std::vector<std::string> binaryArgs { "--batch" };
+	std::size_t runsCount { 3 };
+};
+
+struct RunResult
+{
+	std::chrono::nanoseconds wallTime;
+	std::string output;
+};
+
+[[ nodiscard ]] HarnessSettings parse_settings( const std::span<char* const> args )
+{
+	using std::string_view_literals::operator""sv;
+
+	static constexpr std::string_view binary_option_prefix { "--binary="sv };
+	static constexpr std::string_view binary_arg_option_prefix { "--binary-arg="sv };
+	static constexpr std::string_view runs_option_prefix { "--runs="sv };
+
+	HarnessSettings settings { };
+
+	for ( const std::string_view arg : args.subspan( std::min<std::size_t>( args.size( ), 1 ) ) )
+	{
+		if ( workload::parse_workload_option( arg, settings.workloadSettings ) ) { continue; }
+
+		if ( arg.starts_with( binary_option_prefix ) )
+		{
+			settings.binaryPath = arg.substr( binary_option_prefix.size( ) );
+		}
+		else if ( arg.starts_with( binary_arg_option_prefix ) )
+		{
+			settings.binaryArgs.emplace_back( arg.substr( binary_arg_option_prefix.size( ) ) );
+		}
+		else if ( arg.starts_with( runs_option_prefix ) )
+		{
+			settings.runsCount = util::parse_option_value<std::size_t>( arg, runs_option_prefix, 1 );
+		}
+		else
+		{
+			throw std::runtime_error( "Invalid_Option_Exception: Unknown option '" + std::string { arg } + "'" );
+		}
+	}
+
+	return settings;
+}
+
+#if PN_POSIX_IO == 1
+// runs the binary with input on its standard input while its standard output is
+// collected, the input is written from a second thread so that neither pipe can
+// fill up and stall the other
+[[ nodiscard ]] RunResult run_binary( const HarnessSettings& settings, const std::string_view input )
+{
+	std::array<int, 2> inputPipe;
+	std::array<int, 2> outputPipe;
+
+	if ( ::pipe( inputPipe.data( ) ) != 0 || ::pipe( outputPipe.data( ) ) != 0 )
+	{
+		throw std::runtime_error( std::string { "Harness_Exception: pipe( ) failed: " } + std::strerror( errno ) );
+	}
+
+	::posix_spawn_file_actions_t file_actions;
+	::posix_spawn_file_actions_init( &file_actions );
+	::posix_spawn_file_actions_adddup2( &file_actions, inputPipe[ 0 ], STDIN_FILENO );
+	::posix_spawn_file_actions_adddup2( &file_actions, outputPipe[ 1 ], STDOUT_FILENO );
+
+	for ( const int fd : { inputPipe[ 0 ], inputPipe[ 1 ], outputPipe[ 0 ], outputPipe[ 1 ] } )
+	{
+		::posix_spawn_file_actions_addclose( &file_actions, fd );
+	}
+
+	std::vector<char*> argv;
+	argv.push_back( const_cast<char*>( settings.binaryPath.c_str( ) ) );
+
+	for ( const std::string& binaryArg : settings.binaryArgs )
+	{
+		argv.push_back( const_cast<char*>( binaryArg.c_str( ) ) );
+	}
+
+	argv.push_back( nullptr );
+
+	const auto start { std::chrono::steady_clock::now( ) };
+
+	::pid_t pid { };
+	const int spawnError { ::posix_spawn( &pid, settings.binaryPath.c_str( ), &file_actions, nullptr,
+										  argv.data( ), environ ) };
+
+	::posix_spawn_file_actions_destroy( &file_actions );
+	::close( inputPipe[ 0 ] );
+	::close( outputPipe[ 1 ] );
+
+	if ( spawnError != 0 )
+	{
+		::close( inputPipe[ 1 ] );
+		::close( outputPipe[ 0 ] );
+
+		throw std::runtime_error( "Harness_Exception: Could not run '" + settings.binaryPath + "': " +
+								  std::strerror( spawnError ) );
+	}
+
+	std::jthread writer { [ fd = inputPipe[ 1 ], input ]( )
+	{
+		for ( std::size_t offset { }; offset < input.size( ); )
+		{
+			const ::ssize_t writtenCount { ::write( fd, input.data( ) + offset, input.size( ) - offset ) };
+
+			if ( writtenCount < 0 && errno == EINTR ) { continue; }
+			if ( writtenCount <= 0 ) { break; } // the binary went away, its exit status tells why
+
+			offset += static_cast<std::size_t>( writtenCount );
+		}
+
+		::close( fd );
+	} };
+
+	RunResult result { };
+	std::array<char, 64 * 1024> block;
+
+	while ( true )
+	{
+		const ::ssize_t readCount { ::read( outputPipe[ 0 ], block.data( ), block.size( ) ) };
+
+		if ( readCount < 0 && errno == EINTR ) { continue; }
+		if ( readCount <= 0 ) { break; }
+
+		result.output.append( block.data( ), static_cast<std::size_t>( readCount ) );
+	}
+
+	::close( outputPipe[ 0 ] );
+	writer.join( );
+
+	int status { };
+	while ( ::waitpid( pid, &status, 0 ) == -1 && errno == EINTR ) { }
+
+	result.wallTime = std::chrono::steady_clock::now( ) - start;
+
+	if ( !WIFEXITED( status ) || WEXITSTATUS( status ) != EXIT_SUCCESS )
+	{
+		throw std::runtime_error( "Harness_Exception: '" + settings.binaryPath + "' did not exit successfully" );
+	}
+
+	return result;
+}
+#else
+[[ nodiscard ]] RunResult run_binary( const HarnessSettings&, const std::string_view )
+{
+	throw std::runtime_error( "Harness_Exception: Running the binary is only supported on POSIX systems" );
+}
+#endif
+
+// describes where output first differs from expectedOutput, in documents, rows
+// and columns of the canvas
+[[ nodiscard ]] std::string describe_mismatch( const workload::WorkloadSettings& workloadSettings,
+											   const std::string_view output, const std::string_view expectedOutput )
+{
+	const std::size_t offset { static_cast<std::size_t>(
+		std::ranges::mismatch( output, expectedOutput ).in1 - output.begin( ) ) };
+	const std::size_t documentLen { std::size_t { workloadSettings.Y_AxisLen } * workloadSettings.X_AxisLen };
+
+	return "the output differs from the reference at byte " + std::to_string( offset ) + " (document " +
+		   std::to_string( offset / documentLen ) + ", row " +
+		   std::to_string( offset % documentLen / workloadSettings.X_AxisLen ) + ", column " +
+		   std::to_string( offset % workloadSettings.X_AxisLen ) + "), " + std::to_string( output.size( ) ) +
+		   " bytes were written and " + std::to_string( expectedOutput.size( ) ) + " expected";
+}
+
+[[ nodiscard ]] bool run_harness( const HarnessSettings& settings )
+{
+	std::string input;
+	std::string expectedOutput;
+
+	const workload::WorkloadStats stats { workload::generate_workload( settings.workloadSettings, input,
+																	   &expectedOutput ) };
+
+	std::cout << stats.documentsCount << " documents, " << stats.linesCount << " lines ("
+			  << stats.invalidLinesCount << " invalid), " << input.size( ) << " bytes in, "
+			  << expectedOutput.size( ) << " bytes out\n";
+
+	const std::ios_base::fmtflags coutFlags { std::cout.flags( ) };
+	const std::streamsize coutPrecision { std::cout.precision( 2 ) };
+	std::cout << std::fixed;
+
+	bool isEveryOutputCorrect { true };
+	double bestSeconds { std::numeric_limits<double>::infinity( ) };
+
+	for ( std::size_t run { 1 }; run <= settings.runsCount; ++run )
+	{
+		const RunResult result { run_binary( settings, input ) };
+		const double seconds { std::chrono::duration<double>{ result.wallTime }.count( ) };
+
+		std::cout << "run " << run << ": " << seconds * 1000.0 << " ms, "
+				  << static_cast<double>( stats.linesCount ) / seconds / 1e6 << " M lines/s, "
+				  << static_cast<double>( input.size( ) ) / seconds / 1e6 << " MB/s";
+
+		if ( result.output == expectedOutput )
+		{
+			std::cout << ", output matches the reference\n";
+			bestSeconds = std::min( bestSeconds, seconds );
+		}
+		else
+		{
+			std::cout << ", " << describe_mismatch( settings.workloadSettings, result.output, expectedOutput ) << '\n';
+			isEveryOutputCorrect = false;
+		}
+	}
+
+	if ( isEveryOutputCorrect )
+	{
+		std::cout << "best: " << static_cast<double>( stats.linesCount ) / bestSeconds / 1e6 << " M lines/s, "
+				  << static_cast<double>( input.size( ) ) / bestSeconds / 1e6 << " MB/s\n";
+	}
+
+	std::cout.flags( coutFlags );
+	std::cout.precision( coutPrecision );
+
+	return isEveryOutputCorrect;
+}
+
+}
+
+
+namespace pnt = peyknowruzi::throughput;
+
+
+int main( int argc, char* argv[] )
+{
+	const std::span<char* const> args { argv, static_cast<std::size_t>( argc ) };
+
+#if PN_POSIX_IO == 1
+	// a binary that exits before reading all of its input must fail its run, not
+	// take the harness down with it
+	std::signal( SIGPIPE, SIG_IGN );
+#endif
+
+	try
+	{
+		const pnt::HarnessSettings settings { pnt::parse_settings( args ) };
+
+		return pnt::run_harness( settings ) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+	catch ( const std::bad_alloc& )
+	{
+		std::cerr << "Memory_Exception: Ran out of memory\n";
+		return EXIT_FAILURE;
+	}
+	catch ( const std::exception& ex )
+	{
+		std::cerr << ex.what( ) << '\n';
+		return EXIT_FAILURE;
+	}
+}
@@ -23,14 +23,911 @@
 
 
 #include "Util.hpp"
+#include "Counters.hpp"
 #include "pch.hpp"
 
+#if defined( __unix__ ) || defined( __APPLE__ )
+#define PN_POSIX_IO 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#else
+#define PN_POSIX_IO 0
+#endif
+
+#if defined( __AVX2__ ) || defined( __SSE2__ ) || defined( __SSSE3__ )
+#include <immintrin.h>
+#endif
+
 
 using std::size_t;
+using std::uint64_t;
 
 namespace peyknowruzi::util
 {
 
+static constexpr size_t delimiter_block_len { 64 };
+
+// bit i is set when block[ i ] is a space or a tab, for delimiter_block_len bytes
+[[ nodiscard ]] static uint64_t
+find_delimiters( const char* const block ) noexcept
+{
+	uint64_t delimiterMask { };
+
+#if defined( __AVX2__ )
+	for ( size_t idx { }; idx < delimiter_block_len; idx += 32 )
+	{
+		const __m256i chars { _mm256_loadu_si256( reinterpret_cast<const __m256i*>( block + idx ) ) };
+		const __m256i delimiters { _mm256_or_si256( _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( ' ' ) ),
+													_mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '\t' ) ) ) };
+
+		delimiterMask |= uint64_t { static_cast<std::uint32_t>( _mm256_movemask_epi8( delimiters ) ) } << idx;
+	}
+#elif defined( __SSE2__ )
+	for ( size_t idx { }; idx < delimiter_block_len; idx += 16 )
+	{
+		const __m128i chars { _mm_loadu_si128( reinterpret_cast<const __m128i*>( block + idx ) ) };
+		const __m128i delimiters { _mm_or_si128( _mm_cmpeq_epi8( chars, _mm_set1_epi8( ' ' ) ),
+												 _mm_cmpeq_epi8( chars, _mm_set1_epi8( '\t' ) ) ) };
+
+		delimiterMask |= uint64_t { static_cast<std::uint32_t>( _mm_movemask_epi8( delimiters ) ) } << idx;
+	}
+#else
+	for ( size_t idx { }; idx < delimiter_block_len; ++idx )
+	{
+		if ( block[ idx ] == ' ' || block[ idx ] == '\t' ) { delimiterMask |= uint64_t { 1 } << idx; }
+	}
+#endif
+
+	return delimiterMask;
+}
+
+// the same for the len < delimiter_block_len bytes at the end of an input;
+// the missing tail is padded with delimiters so that it never extends a token
+[[ nodiscard ]] static uint64_t
+find_delimiters_in_tail( const char* const tail, const size_t len ) noexcept
+{
+	alignas( delimiter_block_len ) std::array<char, delimiter_block_len> paddedBlock;
+	paddedBlock.fill( ' ' );
+	std::memcpy( paddedBlock.data( ), tail, len );
+
+	return find_delimiters( paddedBlock.data( ) );
+}
+
+// bit i is set when block[ i ] is neither skippedChar nor a newline
+[[ nodiscard ]] static uint64_t
+find_cells_to_hash( const char* const block, const char skippedChar ) noexcept
+{
+	uint64_t skippedMask { };
+
+#if defined( __AVX2__ )
+	for ( size_t idx { }; idx < 64; idx += 32 )
+	{
+		const __m256i chars { _mm256_loadu_si256( reinterpret_cast<const __m256i*>( block + idx ) ) };
+		const __m256i skipped { _mm256_or_si256( _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( skippedChar ) ),
+												 _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '\n' ) ) ) };
+
+		skippedMask |= uint64_t { static_cast<std::uint32_t>( _mm256_movemask_epi8( skipped ) ) } << idx;
+	}
+#elif defined( __SSE2__ )
+	for ( size_t idx { }; idx < 64; idx += 16 )
+	{
+		const __m128i chars { _mm_loadu_si128( reinterpret_cast<const __m128i*>( block + idx ) ) };
+		const __m128i skipped { _mm_or_si128( _mm_cmpeq_epi8( chars, _mm_set1_epi8( skippedChar ) ),
+											  _mm_cmpeq_epi8( chars, _mm_set1_epi8( '\n' ) ) ) };
+
+		skippedMask |= uint64_t { static_cast<std::uint32_t>( _mm_movemask_epi8( skipped ) ) } << idx;
+	}
+#else
+	for ( size_t idx { }; idx < 64; ++idx )
+	{
+		if ( block[ idx ] == skippedChar || block[ idx ] == '\n' ) { skippedMask |= uint64_t { 1 } << idx; }
+	}
+#endif
+
+	return ~skippedMask;
+}
+
+[[ nodiscard ]] uint64_t
+hash_dense_cells( const std::string_view characterMatrix, const std::uint32_t X_AxisLen,
+				  const char fillCharacter ) noexcept
+{
+	uint64_t hashValue { };
+
+	const auto hash_block { [ & ]( const char* const block, const size_t offset )
+	{
+		for ( uint64_t mask { find_cells_to_hash( block, fillCharacter ) }; mask != 0; mask &= mask - 1 )
+		{
+			const size_t cellOffset { offset + static_cast<size_t>( std::countr_zero( mask ) ) };
+
+			hashValue += mix_cell( static_cast<std::uint32_t>( cellOffset % X_AxisLen ),
+								   static_cast<std::uint32_t>( cellOffset / X_AxisLen ),
+								   block[ cellOffset - offset ] );
+		}
+	} };
+
+	size_t offset { };
+
+	for ( ; offset + 64 <= characterMatrix.size( ); offset += 64 )
+	{
+		hash_block( characterMatrix.data( ) + offset, offset );
+	}
+
+	if ( offset < characterMatrix.size( ) )
+	{
+		std::array<char, 64> paddedBlock;
+		paddedBlock.fill( fillCharacter );
+		std::memcpy( paddedBlock.data( ), characterMatrix.data( ) + offset, characterMatrix.size( ) - offset );
+
+		hash_block( paddedBlock.data( ), offset );
+	}
+
+	return hashValue;
+}
+
+#if defined( __AVX2__ )
+static constexpr size_t mismatch_block_len { 32 };
+#elif defined( __SSE2__ )
+static constexpr size_t mismatch_block_len { 16 };
+#else
+static constexpr size_t mismatch_block_len { 8 };
+#endif
+
+// bit i is set when lhs[ i ] differs from rhs[ i ], for mismatch_block_len bytes
+[[ nodiscard ]] static std::uint32_t
+find_mismatches_in_block( const char* const lhs, const char* const rhs ) noexcept
+{
+#if defined( __AVX2__ )
+	const __m256i equal { _mm256_cmpeq_epi8( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( lhs ) ),
+											 _mm256_loadu_si256( reinterpret_cast<const __m256i*>( rhs ) ) ) };
+
+	return ~static_cast<std::uint32_t>( _mm256_movemask_epi8( equal ) );
+#elif defined( __SSE2__ )
+	const __m128i equal { _mm_cmpeq_epi8( _mm_loadu_si128( reinterpret_cast<const __m128i*>( lhs ) ),
+										  _mm_loadu_si128( reinterpret_cast<const __m128i*>( rhs ) ) ) };
+
+	return ~static_cast<std::uint32_t>( _mm_movemask_epi8( equal ) ) & 0xFFFF;
+#else
+	std::uint32_t mismatches { };
+
+	for ( size_t idx { }; idx < mismatch_block_len; ++idx )
+	{
+		if ( lhs[ idx ] != rhs[ idx ] ) { mismatches |= std::uint32_t { 1 } << idx; }
+	}
+
+	return mismatches;
+#endif
+}
+
+[[ nodiscard ]] size_t
+find_first_mismatch( const std::string_view lhs, const std::string_view rhs ) noexcept
+{
+	const size_t len { std::min( lhs.size( ), rhs.size( ) ) };
+	size_t offset { };
+
+	for ( ; offset + mismatch_block_len <= len; offset += mismatch_block_len )
+	{
+		if ( const std::uint32_t mismatches { find_mismatches_in_block( lhs.data( ) + offset, rhs.data( ) + offset ) };
+			 mismatches != 0 )
+		{
+			return offset + static_cast<size_t>( std::countr_zero( mismatches ) );
+		}
+	}
+
+	for ( ; offset < len; ++offset )
+	{
+		if ( lhs[ offset ] != rhs[ offset ] ) { return offset; }
+	}
+
+	return len;
+}
+
+[[ nodiscard ]] size_t
+find_last_mismatch( const std::string_view lhs, const std::string_view rhs ) noexcept
+{
+	const size_t len { std::min( lhs.size( ), rhs.size( ) ) };
+	size_t end { len };
+
+	for ( ; end >= mismatch_block_len; end -= mismatch_block_len )
+	{
+		const size_t offset { end - mismatch_block_len };
+
+		if ( const std::uint32_t mismatches { find_mismatches_in_block( lhs.data( ) + offset, rhs.data( ) + offset ) };
+			 mismatches != 0 )
+		{
+			return offset + 31 - static_cast<size_t>( std::countl_zero( mismatches ) );
+		}
+	}
+
+	while ( end > 0 )
+	{
+		--end;
+		if ( lhs[ end ] != rhs[ end ] ) { return end; }
+	}
+
+	return len;
+}
+
+void expand_nibbles( const unsigned char* const packed, const std::size_t nibblesCount,
+					 const std::array<char, 16>& palette, char* const expanded_OUT ) noexcept
+{
+	size_t nibbleIdx { };
+
+#if defined( __SSSE3__ )
+	const __m128i paletteChars { _mm_loadu_si128( reinterpret_cast<const __m128i*>( palette.data( ) ) ) };
+	const __m128i lowNibbleMask { _mm_set1_epi8( 0x0F ) };
+
+	for ( ; nibbleIdx + 32 <= nibblesCount; nibbleIdx += 32 )
+	{
+		const __m128i codes { _mm_loadu_si128( reinterpret_cast<const __m128i*>( packed + nibbleIdx / 2 ) ) };
+		const __m128i evenChars { _mm_shuffle_epi8( paletteChars, _mm_and_si128( codes, lowNibbleMask ) ) };
+		const __m128i oddChars { _mm_shuffle_epi8( paletteChars,
+												   _mm_and_si128( _mm_srli_epi16( codes, 4 ), lowNibbleMask ) ) };
+
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( expanded_OUT + nibbleIdx ),
+						  _mm_unpacklo_epi8( evenChars, oddChars ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( expanded_OUT + nibbleIdx + 16 ),
+						  _mm_unpackhi_epi8( evenChars, oddChars ) );
+	}
+#endif
+
+	for ( ; nibbleIdx < nibblesCount; ++nibbleIdx )
+	{
+		const unsigned char code { static_cast<unsigned char>( packed[ nibbleIdx / 2 ] >> ( nibbleIdx % 2 * 4 ) ) };
+
+		expanded_OUT[ nibbleIdx ] = palette[ code & 0x0F ];
+	}
+}
+
+// Walks delimiter masks block by block and turns every token edge into a
+// string_view; a token that is still open at the end of a block carries over.
+class TokenScanner
+{
+public:
+	TokenScanner( const char* const base, const std::span< std::string_view > foundTokens_OUT,
+				  const size_t expectedTokenCount ) noexcept
+
+		: m_base( base ), m_foundTokens( foundTokens_OUT ), m_expectedTokenCount( expectedTokenCount ),
+		  m_foundTokensCount( 0 ), m_tokenStart( std::string_view::npos ), m_isPrevCharInToken( 0 )
+	{
+	}
+
+	[[ nodiscard ]] bool scan( const uint64_t delimiterMask, const size_t blockOffset ) noexcept
+	{
+		const uint64_t tokenMask { ~delimiterMask };
+
+		uint64_t edges { tokenMask ^ ( ( tokenMask << 1 ) | m_isPrevCharInToken ) };
+		m_isPrevCharInToken = tokenMask >> 63;
+
+		for ( ; edges != 0; edges &= edges - 1 )
+		{
+			const size_t pos { blockOffset + static_cast<size_t>( std::countr_zero( edges ) ) };
+
+			if ( m_tokenStart == std::string_view::npos )
+			{
+				if ( m_foundTokensCount == m_expectedTokenCount ) { return false; }
+
+				m_tokenStart = pos;
+			}
+			else
+			{
+				m_foundTokens[ m_foundTokensCount++ ] = { m_base + m_tokenStart, pos - m_tokenStart };
+				m_tokenStart = std::string_view::npos;
+			}
+		}
+
+		return true;
+	}
+
+	[[ nodiscard ]] size_t finish( const size_t endOffset ) noexcept
+	{
+		if ( m_tokenStart != std::string_view::npos )
+		{
+			m_foundTokens[ m_foundTokensCount++ ] = { m_base + m_tokenStart, endOffset - m_tokenStart };
+			m_tokenStart = std::string_view::npos;
+		}
+
+		return m_foundTokensCount;
+	}
+
+private:
+	const char* const m_base;
+	const std::span< std::string_view > m_foundTokens;
+	const size_t m_expectedTokenCount;
+	size_t m_foundTokensCount;
+	size_t m_tokenStart;
+	uint64_t m_isPrevCharInToken;
+};
+
+MappedFile::MappedFile( const std::string& filePath )
+
+	: m_mappedAddress( nullptr ), m_mappedLen( 0 )
+{
+#if PN_POSIX_IO == 1
+	const int fd { ::open( filePath.c_str( ), O_RDONLY ) };
+
+	if ( fd == -1 )
+	{
+		throw std::runtime_error( "Input_File_Exception: Could not open '" + filePath + "': " +
+								  std::strerror( errno ) );
+	}
+
+	struct stat fileStatus { };
+
+	if ( ::fstat( fd, &fileStatus ) == 0 && S_ISREG( fileStatus.st_mode ) && fileStatus.st_size > 0 )
+	{
+		m_mappedLen = static_cast<size_t>( fileStatus.st_size );
+		m_mappedAddress = ::mmap( nullptr, m_mappedLen, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+		if ( m_mappedAddress == MAP_FAILED )
+		{
+			m_mappedAddress = nullptr;
+			m_mappedLen = 0;
+		}
+		else
+		{
+			::madvise( m_mappedAddress, m_mappedLen, MADV_SEQUENTIAL );
+		}
+	}
+
+	::close( fd );
+
+	if ( m_mappedAddress != nullptr || ( S_ISREG( fileStatus.st_mode ) && fileStatus.st_size == 0 ) )
+	{
+		return;
+	}
+#endif
+
+	// pipes, devices and platforms without mmap are read into memory once instead
+	std::ifstream ifs { filePath, std::ios_base::binary };
+
+	if ( !ifs )
+	{
+		throw std::runtime_error( "Input_File_Exception: Could not open '" + filePath + "'" );
+	}
+
+	m_fallbackContents.assign( std::istreambuf_iterator<char>( ifs ), std::istreambuf_iterator<char>( ) );
+}
+
+MappedFile::~MappedFile( )
+{
+#if PN_POSIX_IO == 1
+	if ( m_mappedAddress != nullptr )
+	{
+		::munmap( m_mappedAddress, m_mappedLen );
+	}
+#endif
+}
+
+[[ nodiscard ]] std::string_view
+MappedFile::getContents( ) const noexcept
+{
+	if ( m_mappedAddress != nullptr )
+	{
+		return { static_cast<const char*>( m_mappedAddress ), m_mappedLen };
+	}
+
+	// an empty file maps nothing, but its contents still go to memchr and memcpy,
+	// which take no null pointer even for zero bytes
+	if ( m_fallbackContents.empty( ) ) { return ""; }
+
+	return { m_fallbackContents.data( ), m_fallbackContents.size( ) };
+}
+
+MappedArena::MappedArena( const std::size_t size, [[ maybe_unused ]] const Arena_Backing backing )
+
+	: m_mappedAddress( nullptr ), m_mappedLen( 0 ), m_buffer( )
+{
+#if PN_POSIX_IO == 1
+	static constexpr std::size_t huge_page_size { 2 * 1024 * 1024 };
+
+	if ( size == 0 ) { return; }
+
+	if ( backing == Arena_Backing::huge_pages )
+	{
+#if defined( MAP_HUGETLB )
+		// only succeeds where huge pages have been reserved
+		m_mappedLen = ( size + huge_page_size - 1 ) / huge_page_size * huge_page_size;
+		m_mappedAddress = ::mmap( nullptr, m_mappedLen, PROT_READ | PROT_WRITE,
+								  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+
+		if ( m_mappedAddress != MAP_FAILED )
+		{
+			m_buffer = { static_cast<std::byte*>( m_mappedAddress ), size };
+			return;
+		}
+#endif
+
+		// over-allocate so that the arena can start on a huge page boundary, which
+		// is what lets the kernel back it with transparent huge pages
+		m_mappedLen = size + huge_page_size;
+		m_mappedAddress = ::mmap( nullptr, m_mappedLen, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+
+		if ( m_mappedAddress == MAP_FAILED )
+		{
+			throw std::runtime_error( std::string { "Arena_Allocation_Exception: " } + std::strerror( errno ) );
+		}
+
+		const std::uintptr_t address { reinterpret_cast<std::uintptr_t>( m_mappedAddress ) };
+		const std::size_t offset { ( huge_page_size - address % huge_page_size ) % huge_page_size };
+
+		m_buffer = { static_cast<std::byte*>( m_mappedAddress ) + offset, size };
+
+#if defined( MADV_HUGEPAGE )
+		::madvise( m_buffer.data( ), m_buffer.size( ), MADV_HUGEPAGE );
+#endif
+	}
+	else
+	{
+		int flags { MAP_PRIVATE | MAP_ANONYMOUS };
+#if defined( MAP_POPULATE )
+		flags |= MAP_POPULATE;
+#endif
+		m_mappedLen = size;
+		m_mappedAddress = ::mmap( nullptr, m_mappedLen, PROT_READ | PROT_WRITE, flags, -1, 0 );
+
+		if ( m_mappedAddress == MAP_FAILED )
+		{
+			throw std::runtime_error( std::string { "Arena_Allocation_Exception: " } + std::strerror( errno ) );
+		}
+
+		m_buffer = { static_cast<std::byte*>( m_mappedAddress ), size };
+
+		// MAP_POPULATE is only a request, a write to each page makes sure
+		const long pageSize { ::sysconf( _SC_PAGESIZE ) };
+
+		for ( size_t offset { }; offset < m_buffer.size( ); offset += static_cast<size_t>( pageSize ) )
+		{
+			static_cast<volatile std::byte&>( m_buffer[ offset ] ) = std::byte { };
+		}
+	}
+#else
+	// value-initializing the buffer touches every page of it already
+	m_fallbackBuffer.resize( size );
+	m_buffer = m_fallbackBuffer;
+#endif
+}
+
+MappedArena::~MappedArena( )
+{
+#if PN_POSIX_IO == 1
+	if ( m_mappedAddress != nullptr )
+	{
+		::munmap( m_mappedAddress, m_mappedLen );
+	}
+#endif
+}
+
+[[ nodiscard ]] std::span<std::byte>
+MappedArena::getBuffer( ) noexcept
+{
+	return m_buffer;
+}
+
+[[ nodiscard ]] static std::pair<std::uint64_t, std::uint64_t>
+retrieve_page_faults( ) noexcept
+{
+#if PN_POSIX_IO == 1
+	::rusage usage { };
+
+	if ( ::getrusage( RUSAGE_SELF, &usage ) == 0 )
+	{
+		return { static_cast<std::uint64_t>( usage.ru_minflt ), static_cast<std::uint64_t>( usage.ru_majflt ) };
+	}
+#endif
+
+	return { 0, 0 };
+}
+
+ResourceUsageMeter::ResourceUsageMeter( )
+
+	: m_start( ), m_startMinorPageFaults( 0 ), m_startMajorPageFaults( 0 )
+{
+#if defined( __linux__ )
+	// writing 5 resets the peak resident set size to the current one
+	if ( std::ofstream clear_refs { "/proc/self/clear_refs" } ) { clear_refs << "5"; }
+#endif
+
+	const auto [ minorPageFaults, majorPageFaults ] { retrieve_page_faults( ) };
+	m_startMinorPageFaults = minorPageFaults;
+	m_startMajorPageFaults = majorPageFaults;
+	m_start = std::chrono::steady_clock::now( );
+}
+
+[[ nodiscard ]] ResourceUsage ResourceUsageMeter::getUsage( ) const
+{
+	const auto end { std::chrono::steady_clock::now( ) };
+	const auto [ minorPageFaults, majorPageFaults ] { retrieve_page_faults( ) };
+
+	ResourceUsage usage { end - m_start, minorPageFaults - m_startMinorPageFaults,
+						  majorPageFaults - m_startMajorPageFaults, 0 };
+
+#if defined( __linux__ )
+	std::ifstream status { "/proc/self/status" };
+
+	for ( std::string line; std::getline( status, line ); )
+	{
+		if ( line.starts_with( "VmHWM:" ) )
+		{
+			usage.peakResidentSetKiB = std::strtoull( line.c_str( ) + 6, nullptr, 10 );
+			return usage;
+		}
+	}
+#endif
+
+#if PN_POSIX_IO == 1
+	::rusage processUsage { };
+
+	if ( ::getrusage( RUSAGE_SELF, &processUsage ) == 0 )
+	{
+#if defined( __APPLE__ )
+		usage.peakResidentSetKiB = static_cast<std::uint64_t>( processUsage.ru_maxrss ) / 1024;
+#else
+		usage.peakResidentSetKiB = static_cast<std::uint64_t>( processUsage.ru_maxrss );
+#endif
+	}
+#endif
+
+	return usage;
+}
+
+LineReader::LineReader( std::istream& input_stream, const size_t blockSize )
+
+	: m_inputStream( &input_stream ), m_block( std::max<size_t>( blockSize, 1 ) ),
+	  m_data( m_block.data( ) ), m_lineStart( 0 ), m_dataEnd( 0 ), m_linesReadCount( 0 ), m_isEndOfInput( false )
+{
+}
+
+LineReader::LineReader( const std::string_view inputBuffer ) noexcept
+
+	: m_inputStream( nullptr ), m_block( ), m_data( inputBuffer.data( ) ),
+	  m_lineStart( 0 ), m_dataEnd( inputBuffer.size( ) ), m_linesReadCount( 0 ), m_isEndOfInput( true )
+{
+}
+
+LineReader::~LineReader( )
+{
+	counters::add( counters::Counter::lines_read, m_linesReadCount );
+}
+
+[[ nodiscard ]] std::optional< std::string_view >
+LineReader::getline( )
+{
+	for ( size_t searchStart { m_lineStart }; ; )
+	{
+		const void* const newline { std::memchr( m_data + searchStart, '\n', m_dataEnd - searchStart ) };
+
+		if ( newline != nullptr ) [[ likely ]]
+		{
+			const size_t newlinePos { static_cast<size_t>( static_cast<const char*>( newline ) - m_data ) };
+			const std::string_view line { m_data + m_lineStart, newlinePos - m_lineStart };
+			m_lineStart = newlinePos + 1;
+			++m_linesReadCount;
+
+			return line;
+		}
+
+		if ( m_isEndOfInput )
+		{
+			if ( m_lineStart == m_dataEnd ) { return std::nullopt; }
+
+			const std::string_view line { m_data + m_lineStart, m_dataEnd - m_lineStart };
+			m_lineStart = m_dataEnd;
+			++m_linesReadCount;
+
+			return line;
+		}
+
+		const size_t scannedLen { m_dataEnd - m_lineStart };
+		refill( );
+		searchStart = m_lineStart + scannedLen;
+	}
+}
+
+void LineReader::refill( )
+{
+	const ScopedTimer timer { latency::Phase::input };
+
+	// move the unfinished line to the front so that it stays contiguous,
+	// and grow the block only if that line alone fills all of it
+	if ( m_lineStart != 0 )
+	{
+		std::copy( m_block.begin( ) + static_cast<std::ptrdiff_t>( m_lineStart ),
+				   m_block.begin( ) + static_cast<std::ptrdiff_t>( m_dataEnd ), m_block.begin( ) );
+		m_dataEnd -= m_lineStart;
+		m_lineStart = 0;
+	}
+	else if ( m_dataEnd == m_block.size( ) )
+	{
+		m_block.resize( m_block.size( ) * 2 );
+		m_data = m_block.data( );
+	}
+
+	std::streambuf& input_buffer { *m_inputStream->rdbuf( ) };
+
+	// block only for the first byte, then take whatever is already available;
+	// this keeps interactive input line-responsive while files and pipes are
+	// consumed in large chunks
+	if ( std::char_traits<char>::eq_int_type( input_buffer.sgetc( ), std::char_traits<char>::eof( ) ) )
+	{
+		m_isEndOfInput = true;
+		return;
+	}
+
+	do
+	{
+		const std::streamsize available { std::max<std::streamsize>( input_buffer.in_avail( ), 1 ) };
+		const std::streamsize freeSpace { static_cast<std::streamsize>( m_block.size( ) - m_dataEnd ) };
+		const std::streamsize readCount { input_buffer.sgetn( m_block.data( ) + m_dataEnd,
+															  std::min( available, freeSpace ) ) };
+
+		if ( readCount <= 0 ) { break; }
+
+		m_dataEnd += static_cast<size_t>( readCount );
+
+	} while ( m_dataEnd < m_block.size( ) && input_buffer.in_avail( ) > 0 );
+}
+
+#if PN_POSIX_IO == 1
+// the buffer std::cout starts with, the only one known to end up in stdout;
+// a caller that points std::cout somewhere else with rdbuf( ) keeps its output
+static std::streambuf* const stdout_stream_buffer { std::cout.rdbuf( ) };
+#endif
+
+[[ nodiscard ]] std::optional<FdOutput>
+FdOutput::for_stream( std::ostream& output_stream )
+{
+#if PN_POSIX_IO == 1
+	// anything that is not written to the stdout buffer keeps going through its
+	// own stream buffer
+	if ( output_stream.rdbuf( ) == stdout_stream_buffer && ::fcntl( STDOUT_FILENO, F_GETFL ) != -1 )
+	{
+		output_stream.flush( );
+		return std::optional<FdOutput> { std::in_place, STDOUT_FILENO };
+	}
+#endif
+
+	return std::nullopt;
+}
+
+FdOutput::FdOutput( const int fd ) noexcept
+
+	: m_fd( fd ), m_pendingChunksCount( 0 ), m_pendingChunks( )
+{
+}
+
+void FdOutput::append( const std::string_view chunk )
+{
+	if ( chunk.empty( ) ) { return; }
+
+	if ( m_pendingChunksCount != 0 )
+	{
+		std::string_view& lastChunk { m_pendingChunks[ m_pendingChunksCount - 1 ] };
+
+		if ( lastChunk.data( ) + lastChunk.size( ) == chunk.data( ) )
+		{
+			lastChunk = { lastChunk.data( ), lastChunk.size( ) + chunk.size( ) };
+			return;
+		}
+	}
+
+	if ( m_pendingChunksCount == max_pending_chunks ) { flush( ); }
+
+	m_pendingChunks[ m_pendingChunksCount++ ] = chunk;
+}
+
+void FdOutput::flush( )
+{
+#if PN_POSIX_IO == 1
+	std::array< ::iovec, max_pending_chunks > ioVectors;
+
+	for ( size_t idx { }; idx < m_pendingChunksCount; ++idx )
+	{
+		ioVectors[ idx ] = { const_cast<char*>( m_pendingChunks[ idx ].data( ) ), m_pendingChunks[ idx ].size( ) };
+	}
+
+	::iovec* nextIoVector { ioVectors.data( ) };
+	int remainingCount { static_cast<int>( m_pendingChunksCount ) };
+
+	m_pendingChunksCount = 0;
+
+	while ( remainingCount > 0 )
+	{
+		const ::ssize_t writtenCount { ::writev( m_fd, nextIoVector, remainingCount ) };
+
+		if ( writtenCount == -1 )
+		{
+			if ( errno == EINTR ) { continue; }
+
+			throw std::runtime_error( std::string { "Output_Exception: Could not write the drawing: " } +
+									  std::strerror( errno ) );
+		}
+
+		// skip what was written in full and advance into a partially written chunk
+		size_t unaccountedCount { static_cast<size_t>( writtenCount ) };
+
+		while ( remainingCount > 0 && unaccountedCount >= nextIoVector->iov_len )
+		{
+			unaccountedCount -= nextIoVector->iov_len;
+			++nextIoVector;
+			--remainingCount;
+		}
+
+		if ( remainingCount > 0 )
+		{
+			nextIoVector->iov_base = static_cast<char*>( nextIoVector->iov_base ) + unaccountedCount;
+			nextIoVector->iov_len -= unaccountedCount;
+		}
+	}
+#else
+	for ( size_t idx { }; idx < m_pendingChunksCount; ++idx )
+	{
+		std::cout.write( m_pendingChunks[ idx ].data( ),
+						 static_cast<std::streamsize>( m_pendingChunks[ idx ].size( ) ) );
+	}
+
+	m_pendingChunksCount = 0;
+#endif
+}
+
+BlockQueueStreambuf::BlockQueueStreambuf( BoundedQueue<InputBlock>& blocks ) noexcept
+
+	: m_blocks( &blocks ), m_currentBlock( )
+{
+}
+
+BlockQueueStreambuf::int_type BlockQueueStreambuf::underflow( )
+{
+	if ( gptr( ) < egptr( ) ) { return traits_type::to_int_type( *gptr( ) ); }
+
+	while ( std::optional< InputBlock > block { m_blocks->pop( ) } )
+	{
+		m_currentBlock = std::move( *block );
+
+		if ( m_currentBlock.contents.empty( ) ) { continue; }
+
+		// the get area is never written to, it only has to be non-const for setg
+		char* const begin { const_cast<char*>( m_currentBlock.contents.data( ) ) };
+		setg( begin, begin, begin + m_currentBlock.contents.size( ) );
+
+		return traits_type::to_int_type( *gptr( ) );
+	}
+
+	return traits_type::eof( );
+}
+
+WorkerPool::WorkerPool( )
+
+	: m_function( nullptr ), m_task( nullptr ), m_workersCount( 0 ), m_busyWorkersCount( 0 ),
+	  m_postedJobsCount( 0 ), m_exception( ), m_isStopping( false ), m_threads( )
+{
+}
+
+WorkerPool::~WorkerPool( )
+{
+	{
+		const std::scoped_lock lock { m_mutex };
+		m_isStopping = true;
+	}
+
+	// the threads are joined as m_threads goes, before anything they wait on
+	m_jobPosted.notify_all( );
+}
+
+void WorkerPool::run( const std::size_t workersCount, const task_function function, const void* const task )
+{
+	if ( workersCount == 0 ) { return; }
+
+	const std::scoped_lock run_lock { m_runMutex };
+
+	{
+		const std::scoped_lock lock { m_mutex };
+
+		// the calling thread is worker 0, the pool only holds the others
+		while ( m_threads.size( ) + 1 < workersCount )
+		{
+			m_threads.emplace_back( [ this, workerIdx = m_threads.size( ) + 1, seenJobsCount = m_postedJobsCount ]
+									{ work( workerIdx, seenJobsCount ); } );
+		}
+
+		m_function = function;
+		m_task = task;
+		m_workersCount = workersCount;
+		m_busyWorkersCount = workersCount - 1;
+		m_exception = nullptr;
+		++m_postedJobsCount;
+	}
+
+	m_jobPosted.notify_all( );
+
+	std::exception_ptr exception { };
+
+	try { function( task, 0 ); }
+	catch ( ... ) { exception = std::current_exception( ); }
+
+	{
+		std::unique_lock lock { m_mutex };
+		m_jobDone.wait( lock, [ this ] { return m_busyWorkersCount == 0; } );
+
+		if ( exception == nullptr ) { exception = std::exchange( m_exception, nullptr ); }
+	}
+
+	if ( exception != nullptr ) { std::rethrow_exception( exception ); }
+}
+
+void WorkerPool::work( const std::size_t workerIdx, std::uint64_t seenJobsCount )
+{
+	std::unique_lock lock { m_mutex };
+
+	while ( true )
+	{
+		m_jobPosted.wait( lock, [ & ] { return m_isStopping || m_postedJobsCount != seenJobsCount; } );
+
+		if ( m_isStopping ) { return; }
+
+		seenJobsCount = m_postedJobsCount;
+
+		// a job for fewer workers than the pool holds leaves the rest idle
+		if ( workerIdx >= m_workersCount ) { continue; }
+
+		const task_function function { m_function };
+		const void* const task { m_task };
+		lock.unlock( );
+
+		std::exception_ptr exception { };
+
+		try { function( task, workerIdx ); }
+		catch ( ... ) { exception = std::current_exception( ); }
+
+		lock.lock( );
+
+		if ( exception != nullptr && m_exception == nullptr ) { m_exception = exception; }
+
+		if ( --m_busyWorkersCount == 0 ) { m_jobDone.notify_one( ); }
+	}
+}
+
+DiscardingStreambuf::int_type DiscardingStreambuf::overflow( const int_type ch )
+{
+	return traits_type::not_eof( ch );
+}
+
+std::streamsize DiscardingStreambuf::xsputn( const char* const, const std::streamsize count )
+{
+	return count;
+}
+
+void ExitReport::enable( const std::string_view outputFilePath ) noexcept
+{
+	m_isEnabled = true;
+	m_outputFilePath = outputFilePath;
+}
+
+[[ nodiscard ]] bool ExitReport::isEnabled( ) const noexcept
+{
+	return m_isEnabled;
+}
+
+void ExitReport::write( const std::string_view report ) const
+{
+	if ( m_outputFilePath.empty( ) )
+	{
+		std::cerr << report << std::flush;
+		return;
+	}
+
+	std::ofstream ofs { std::string { m_outputFilePath }, std::ios_base::trunc };
+	ofs << report;
+
+	if ( !ofs.flush( ) )
+	{
+		std::cerr << m_exceptionName << ": Could not write '" << m_outputFilePath << "'\n";
+	}
+}
+
 [[ nodiscard ]] std::vector< std::string_view >
 tokenize( const std::string_view inputStr,
 		  const size_t expectedTokenCount )
@@ -65,32 +962,127 @@ tokenize_fast( const std::string_view inputStr,
 			   const std::span< std::string_view > foundTokens_OUT,
 			   const size_t expectedTokenCount ) noexcept
 {
-	size_t foundTokensCount { };
-
 	if ( inputStr.empty( ) ) [[ unlikely ]]
 	{
-		return foundTokensCount = 0;
+		return 0;
 	}
 
-	static constexpr std::string_view delimiter { " \t" };
+	TokenScanner scanner { inputStr.data( ), foundTokens_OUT, expectedTokenCount };
 
-	size_t start { inputStr.find_first_not_of( delimiter ) };
+	size_t offset { };
 
-	for ( size_t idx { }, end { }
-		  ; start != std::string_view::npos && foundTokensCount < expectedTokenCount; ++idx )
+	for ( ; offset + delimiter_block_len <= inputStr.size( ); offset += delimiter_block_len )
 	{
-		end = inputStr.find_first_of( delimiter, start );
-		foundTokens_OUT[ idx ] = inputStr.substr( start, end - start );
-		++foundTokensCount;
-		start = inputStr.find_first_not_of( delimiter, end );
+		if ( !scanner.scan( find_delimiters( inputStr.data( ) + offset ), offset ) )
+		{
+			return std::numeric_limits<size_t>::max( );
+		}
 	}
 
-	if ( start != std::string_view::npos )
+	if ( offset < inputStr.size( ) &&
+		 !scanner.scan( find_delimiters_in_tail( inputStr.data( ) + offset, inputStr.size( ) - offset ), offset ) )
 	{
-		return foundTokensCount = std::numeric_limits<size_t>::max( );
+		return std::numeric_limits<size_t>::max( );
 	}
 
-	return foundTokensCount;
+	return scanner.finish( inputStr.size( ) );
 }
 
+[[ nodiscard ]] static constexpr bool
+is_delimiter( const char ch ) noexcept
+{
+	return ch == ' ' || ch == '\t';
+}
+
+// Converts the run of up to 8 decimal digits at the start of chunk, which
+// holds the characters in memory order ( i.e. little-endian ), in three
+// multiply-and-shift steps instead of one multiply per digit.
+[[ nodiscard ]] static constexpr uint64_t
+convert_digits_swar( uint64_t chunk, const size_t digitCount ) noexcept
+{
+	chunk = ( chunk & 0x0F0F0F0F0F0F0F0F ) << ( 8 * ( 8 - digitCount ) );
+	chunk = ( chunk * 2561 ) >> 8;
+	chunk = ( ( chunk & 0x00FF00FF00FF00FF ) * 6553601 ) >> 16;
+	chunk = ( ( chunk & 0x0000FFFF0000FFFF ) * 42949672960001 ) >> 32;
+
+	return chunk;
 }
+
+[[ nodiscard ]] static std::optional< std::uint32_t >
+parse_digits( const char*& pos, const char* const end, const std::uint32_t maxAcceptableValue ) noexcept
+{
+	static constexpr std::array<uint64_t, 9> powers_of_10 { 1, 10, 100, 1'000, 10'000, 100'000,
+															1'000'000, 10'000'000, 100'000'000 };
+
+	uint64_t value { };
+	size_t digitCount { };
+
+	if constexpr ( std::endian::native == std::endian::little )
+	{
+		for ( ; ; )
+		{
+			const size_t available { static_cast<size_t>( end - pos ) };
+
+			// bytes past the end stay zero, which is never a digit
+			uint64_t chunk { };
+			std::memcpy( &chunk, pos, std::min<size_t>( available, sizeof( chunk ) ) );
+
+			const uint64_t nonDigits { ( ( chunk - 0x3030303030303030 ) | ( chunk + 0x4646464646464646 ) ) &
+									   0x8080808080808080 };
+			const size_t chunkDigitCount { nonDigits == 0 ? 8 : static_cast<size_t>( std::countr_zero( nonDigits ) ) / 8 };
+
+			if ( chunkDigitCount == 0 ) { break; }
+
+			value = value * powers_of_10[ chunkDigitCount ] + convert_digits_swar( chunk, chunkDigitCount );
+			pos += chunkDigitCount;
+			digitCount += chunkDigitCount;
+
+			if ( value > maxAcceptableValue ) { return std::nullopt; }
+
+			if ( chunkDigitCount < 8 ) { break; }
+		}
+	}
+	else
+	{
+		for ( ; pos != end && *pos >= '0' && *pos <= '9'; ++pos, ++digitCount )
+		{
+			value = value * 10 + static_cast<uint64_t>( *pos - '0' );
+
+			if ( value > maxAcceptableValue ) { return std::nullopt; }
+		}
+	}
+
+	if ( digitCount == 0 ) { return std::nullopt; }
+
+	return static_cast<std::uint32_t>( value );
+}
+
+[[ nodiscard ]] bool
+parse_uint32_quad( const std::string_view inputStr,
+				   std::array<std::uint32_t, 4>& result_integers_OUT,
+				   const std::array<std::uint32_t, 4>& maxAcceptableValues ) noexcept
+{
+	// accepts exactly what tokenize_fast followed by to_integer accepts:
+	// four space/tab separated tokens, each an optional '+' and a digit run
+	const char* pos { inputStr.data( ) };
+	const char* const end { inputStr.data( ) + inputStr.size( ) };
+
+	for ( size_t idx { }; idx < result_integers_OUT.size( ); ++idx )
+	{
+		while ( pos != end && is_delimiter( *pos ) ) { ++pos; }
+
+		if ( pos != end && *pos == '+' ) { ++pos; }
+
+		const std::optional< std::uint32_t > value { parse_digits( pos, end, maxAcceptableValues[ idx ] ) };
+
+		if ( !value || ( pos != end && !is_delimiter( *pos ) ) ) { return false; }
+
+		result_integers_OUT[ idx ] = *value;
+	}
+
+	while ( pos != end && is_delimiter( *pos ) ) { ++pos; }
+
+	return pos == end;
+}
+
+}
\ No newline at end of file
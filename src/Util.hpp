@@ -26,6 +26,7 @@
 
 #include "pch.hpp"
 #include "Log.hpp"
+#include "Latency.hpp"
 
 
 namespace peyknowruzi::util
@@ -36,11 +37,22 @@ struct ScopedTimer
 	const std::chrono::time_point< std::chrono::steady_clock > start { std::chrono::steady_clock::now( ) };
 		  std::chrono::time_point< std::chrono::steady_clock > end;
 
+	const std::optional< latency::Phase > phase { };
+
 	ScopedTimer( ) = default;
+	// records into the latency histogram of timedPhase instead of logging, so
+	// it is cheap enough to stay in release builds
+	explicit ScopedTimer( const latency::Phase timedPhase ) noexcept : phase( timedPhase ) { }
 	~ScopedTimer( )
 	{
 		end = std::chrono::steady_clock::now( );
 
+		if ( phase.has_value( ) )
+		{
+			latency::record( *phase, end - start );
+			return;
+		}
+
 		try
 		{
 			using std::string_literals::operator""s;
@@ -72,6 +84,235 @@ struct FunctionTimer
 	}
 };
 
+class MappedFile
+{
+public:
+	explicit MappedFile( const std::string& filePath );
+	~MappedFile( );
+	MappedFile( const MappedFile& ) = delete;
+	MappedFile& operator=( const MappedFile& ) = delete;
+
+	[[ nodiscard ]] std::string_view getContents( ) const noexcept;
+
+private:
+	void* m_mappedAddress;
+	std::size_t m_mappedLen;
+	std::vector<char> m_fallbackContents;
+};
+
+enum class Arena_Backing
+{
+	huge_pages,
+	prefaulted,
+};
+
+// An anonymous memory mapping to carve a canvas out of. huge_pages asks for
+// explicit huge pages and falls back to transparent ones, prefaulted has every
+// page touched up front so that drawing does not take page faults; platforms
+// without mmap get an ordinary heap buffer.
+class MappedArena
+{
+public:
+	MappedArena( const std::size_t size, const Arena_Backing backing );
+	~MappedArena( );
+	MappedArena( const MappedArena& ) = delete;
+	MappedArena& operator=( const MappedArena& ) = delete;
+
+	[[ nodiscard ]] std::span<std::byte> getBuffer( ) noexcept;
+
+private:
+	void* m_mappedAddress;
+	std::size_t m_mappedLen;
+	std::span<std::byte> m_buffer;
+	std::vector<std::byte> m_fallbackBuffer;
+};
+
+struct ResourceUsage
+{
+	std::chrono::nanoseconds wallTime;
+	std::uint64_t minorPageFaults;
+	std::uint64_t majorPageFaults;
+	std::uint64_t peakResidentSetKiB; // 0 where the platform does not report it
+};
+
+// Measures what the process uses from its construction up to each call to
+// getUsage( ). The peak resident set can only be reset on Linux; elsewhere it
+// is the peak of the whole process so far.
+class ResourceUsageMeter
+{
+public:
+	ResourceUsageMeter( );
+	ResourceUsageMeter( const ResourceUsageMeter& ) = delete;
+	ResourceUsageMeter& operator=( const ResourceUsageMeter& ) = delete;
+
+	[[ nodiscard ]] ResourceUsage getUsage( ) const;
+
+private:
+	std::chrono::time_point< std::chrono::steady_clock > m_start;
+	std::uint64_t m_startMinorPageFaults;
+	std::uint64_t m_startMajorPageFaults;
+};
+
+class LineReader
+{
+public:
+	static constexpr std::size_t default_block_size { 64 * 1024 };
+
+	explicit LineReader( std::istream& input_stream,
+						 const std::size_t blockSize = default_block_size );
+	explicit LineReader( const std::string_view inputBuffer ) noexcept;
+	~LineReader( ); // adds the lines it handed out to counters::Counter::lines_read
+	LineReader( const LineReader& ) = delete;
+	LineReader& operator=( const LineReader& ) = delete;
+
+	[[ nodiscard ]] std::optional< std::string_view > getline( );
+
+private:
+	void refill( );
+
+	std::istream* m_inputStream;
+	std::vector<char> m_block;
+	const char* m_data;
+	std::size_t m_lineStart;
+	std::size_t m_dataEnd;
+	std::size_t m_linesReadCount;
+	bool m_isEndOfInput;
+};
+
+// Gathers the chunks of memory that make up a drawing and hands them to a file
+// descriptor with writev( ), so rows go out straight from the canvas without
+// being copied into a stream buffer first. Chunks are only referenced and have
+// to stay alive until flush( ) returns; a chunk that continues the previous one
+// in memory is merged into it.
+class FdOutput
+{
+public:
+	static constexpr std::size_t max_pending_chunks { 1024 };
+
+	[[ nodiscard ]] static std::optional<FdOutput> for_stream( std::ostream& output_stream );
+
+	explicit FdOutput( const int fd ) noexcept;
+
+	void append( const std::string_view chunk );
+	void flush( );
+
+private:
+	int m_fd;
+	std::size_t m_pendingChunksCount;
+	std::array< std::string_view, max_pending_chunks > m_pendingChunks;
+};
+
+// A fixed capacity queue that hands items from one pipeline stage to the next.
+// push( ) blocks while the queue is full and pop( ) while it is empty; once the
+// queue is closed push( ) refuses new items and pop( ) drains the remaining ones.
+template < class T >
+class BoundedQueue
+{
+public:
+	explicit BoundedQueue( const std::size_t capacity );
+	BoundedQueue( const BoundedQueue& ) = delete;
+	BoundedQueue& operator=( const BoundedQueue& ) = delete;
+
+	[[ nodiscard ]] bool push( T&& item );
+	[[ nodiscard ]] std::optional<T> pop( );
+	void close( ) noexcept;
+
+private:
+	std::mutex m_mutex;
+	std::condition_variable m_notEmpty;
+	std::condition_variable m_notFull;
+	std::deque<T> m_items;
+	std::size_t m_capacity;
+	bool m_isClosed;
+};
+
+struct InputBlock
+{
+	std::vector<char> storage;
+	std::string_view contents;
+};
+
+// Presents the blocks that arrive through a BoundedQueue as one input stream,
+// so that a LineReader can consume what another thread reads.
+class BlockQueueStreambuf : public std::streambuf
+{
+public:
+	explicit BlockQueueStreambuf( BoundedQueue<InputBlock>& blocks ) noexcept;
+
+protected:
+	int_type underflow( ) override;
+
+private:
+	BoundedQueue<InputBlock>* m_blocks;
+	InputBlock m_currentBlock;
+};
+
+// Threads that outlive the jobs they run, so that a job split across threads
+// does not start and join a thread per part. run( ) calls task( workerIdx ) for
+// every workerIdx below workersCount, the first one on the calling thread, and
+// returns once all of them did, rethrowing the first exception any of them threw.
+// The pool grows to the largest workersCount it was asked for; concurrent calls
+// to run( ) take turns.
+class WorkerPool
+{
+public:
+	WorkerPool( );
+	WorkerPool( const WorkerPool& ) = delete;
+	WorkerPool& operator=( const WorkerPool& ) = delete;
+	~WorkerPool( );
+
+	template < class Task >
+	void run( const std::size_t workersCount, const Task& task );
+
+private:
+	using task_function = void ( * )( const void* const task, const std::size_t workerIdx );
+
+	void run( const std::size_t workersCount, const task_function function, const void* const task );
+	void work( const std::size_t workerIdx, std::uint64_t seenJobsCount );
+
+	std::mutex m_runMutex;
+	std::mutex m_mutex;
+	std::condition_variable m_jobPosted;
+	std::condition_variable m_jobDone;
+	task_function m_function;
+	const void* m_task;
+	std::size_t m_workersCount;
+	std::size_t m_busyWorkersCount;
+	std::uint64_t m_postedJobsCount;
+	std::exception_ptr m_exception;
+	bool m_isStopping;
+	std::vector<std::jthread> m_threads;
+};
+
+// Accepts everything written to it and keeps none of it, for timing code that
+// draws without paying for the output.
+class DiscardingStreambuf : public std::streambuf
+{
+protected:
+	int_type overflow( const int_type ch ) override;
+	std::streamsize xsputn( const char* const, const std::streamsize count ) override;
+};
+
+// Where a report that is written at exit goes: the file given to enable( ), or
+// the standard error when that is empty. Meant for constinit globals, so that
+// write( ) still works from an atexit handler; the path given to enable( ) has
+// to outlive main( ) for the same reason.
+class ExitReport
+{
+public:
+	explicit constexpr ExitReport( const std::string_view exceptionName ) noexcept;
+
+	void enable( const std::string_view outputFilePath ) noexcept;
+	[[ nodiscard ]] bool isEnabled( ) const noexcept;
+	// failing to write is reported on the standard error as exceptionName
+	void write( const std::string_view report ) const;
+
+private:
+	std::string_view m_exceptionName;
+	std::string_view m_outputFilePath;
+	bool m_isEnabled;
+};
+
 [[ nodiscard ]] std::vector< std::string_view >
 tokenize( const std::string_view inputStr,
 		  const std::size_t expectedTokenCount = std::numeric_limits<std::size_t>::max( ) );
@@ -90,6 +331,53 @@ tokenize_fast( const char* const inputStr,
 			   const std::span< std::string_view > foundTokens_OUT,
 			   const std::size_t expectedTokenCount ) noexcept = delete;
 
+[[ nodiscard ]] bool
+parse_uint32_quad( const std::string_view inputStr,
+				   std::array<std::uint32_t, 4>& result_integers_OUT,
+				   const std::array<std::uint32_t, 4>& maxAcceptableValues ) noexcept;
+
+[[ nodiscard ]] bool
+parse_uint32_quad( const char* const inputStr,
+				   std::array<std::uint32_t, 4>& result_integers_OUT,
+				   const std::array<std::uint32_t, 4>& maxAcceptableValues ) noexcept = delete;
+
+// accepts the same input as parse_uint32_quad but reads one character at a time,
+// so that it can also run during constant evaluation
+[[ nodiscard ]] constexpr bool
+parse_uint32_quad_serially( const std::string_view inputStr,
+							std::array<std::uint32_t, 4>& result_integers_OUT,
+							const std::array<std::uint32_t, 4>& maxAcceptableValues ) noexcept
+{
+	const auto is_delimiter { [ ]( const char ch ) { return ch == ' ' || ch == '\t'; } };
+
+	std::size_t pos { };
+
+	for ( std::size_t idx { }; idx < result_integers_OUT.size( ); ++idx )
+	{
+		while ( pos != inputStr.size( ) && is_delimiter( inputStr[ pos ] ) ) { ++pos; }
+
+		if ( pos != inputStr.size( ) && inputStr[ pos ] == '+' ) { ++pos; }
+
+		std::uint64_t value { };
+		const std::size_t digitsStart { pos };
+
+		for ( ; pos != inputStr.size( ) && inputStr[ pos ] >= '0' && inputStr[ pos ] <= '9'; ++pos )
+		{
+			value = value * 10 + static_cast<std::uint64_t>( inputStr[ pos ] - '0' );
+
+			if ( value > maxAcceptableValues[ idx ] ) { return false; }
+		}
+
+		if ( pos == digitsStart || ( pos != inputStr.size( ) && !is_delimiter( inputStr[ pos ] ) ) ) { return false; }
+
+		result_integers_OUT[ idx ] = static_cast<std::uint32_t>( value );
+	}
+
+	while ( pos != inputStr.size( ) && is_delimiter( inputStr[ pos ] ) ) { ++pos; }
+
+	return pos == inputStr.size( );
+}
+
 template < std::integral T >
 [[ nodiscard ]] std::optional<T>
 to_integer( std::string_view token, const std::pair<T, T> acceptableRange =
@@ -117,8 +405,49 @@ convert_specific_tokens_to_integers( const std::span<const std::string_view> tok
 									 { std::numeric_limits<T>::min( ),
 									   std::numeric_limits<T>::max( ) } ) noexcept;
 
-std::size_t
-get_chars_from_input( std::istream& input_stream, const std::span<char> inputBuffer_OUT );
+// the value of a command line option of the form prefix<value>, which has to be
+// a number not less than minValue; anything else is an Invalid_Option_Exception
+template < class T >
+[[ nodiscard ]] T
+parse_option_value( const std::string_view arg, const std::string_view prefix,
+					const T minValue = std::numeric_limits<T>::lowest( ) );
+
+// the finalizer of MurmurHash3 over the position and value of one cell
+[[ nodiscard ]] inline constexpr std::uint64_t
+mix_cell( const std::uint32_t X_Axis, const std::uint32_t Y_Axis, const char ch ) noexcept
+{
+	std::uint64_t hashValue { ( ( std::uint64_t { Y_Axis } << 32 ) | X_Axis ) * 0x9E3779B97F4A7C15 +
+							  static_cast<unsigned char>( ch ) };
+
+	hashValue ^= hashValue >> 33;
+	hashValue *= 0xFF51AFD7ED558CCD;
+	hashValue ^= hashValue >> 33;
+	hashValue *= 0xC4CEB9FE1A85EC53;
+	hashValue ^= hashValue >> 33;
+
+	return hashValue;
+}
+
+// sums mix_cell over the cells of a dense matrix that hold neither the fill
+// character nor a newline; whole blocks of those are skipped with SIMD compares
+[[ nodiscard ]] std::uint64_t
+hash_dense_cells( const std::string_view characterMatrix, const std::uint32_t X_AxisLen,
+				  const char fillCharacter ) noexcept;
+
+// the offset of the first and of the last byte where two ranges of the same
+// size differ, or their size when they are equal; compared a block at a time
+// and stopping at the first block that differs
+[[ nodiscard ]] std::size_t
+find_first_mismatch( const std::string_view lhs, const std::string_view rhs ) noexcept;
+
+[[ nodiscard ]] std::size_t
+find_last_mismatch( const std::string_view lhs, const std::string_view rhs ) noexcept;
+
+// turns nibblesCount 4 bit codes, two per byte with the first one in the low
+// nibble, into the characters palette assigns to them; 32 codes at a time
+// through a byte shuffle where SSSE3 is available
+void expand_nibbles( const unsigned char* const packed, const std::size_t nibblesCount,
+					 const std::array<char, 16>& palette, char* const expanded_OUT ) noexcept;
 
 #if __cpp_lib_chrono >= 201907L
 [[ nodiscard ]] auto
@@ -150,6 +479,26 @@ to_integer( std::string_view token, const std::pair<T, T> acceptableRange ) noex
 	return result = value;
 }
 
+template < class T >
+[[ nodiscard ]] T
+parse_option_value( const std::string_view arg, const std::string_view prefix, const T minValue )
+{
+	const std::string_view str_value { arg.substr( prefix.size( ) ) };
+	const char* const str_value_end { str_value.data( ) + str_value.size( ) };
+	T value { };
+
+	const auto [ ptr, ec ] { std::from_chars( str_value.data( ), str_value_end, value ) };
+
+	if ( ec != std::errc { } || ptr != str_value_end || value < minValue )
+	{
+		throw std::runtime_error( "Invalid_Option_Exception: '" + std::string { arg } + "' expects a number" +
+								  ( minValue == std::numeric_limits<T>::lowest( ) ? std::string { } :
+									" not less than " + std::to_string( minValue ) ) );
+	}
+
+	return value;
+}
+
 template < std::integral T >
 [[ nodiscard ]] bool
 convert_tokens_to_integers( const std::span<const std::string_view> tokens,
@@ -201,16 +550,75 @@ convert_specific_tokens_to_integers( const std::span<const std::string_view> tok
 	return areTokensConvertibleToValidIntegers = true;
 }
 
-inline std::size_t
-get_chars_from_input( std::istream& input_stream, const std::span<char> inputBuffer_OUT )
+inline constexpr ExitReport::ExitReport( const std::string_view exceptionName ) noexcept
+
+	: m_exceptionName( exceptionName ), m_outputFilePath( ), m_isEnabled( false )
 {
-	input_stream.putback( '\n' );
-	input_stream.clear( );
-	input_stream.ignore( std::numeric_limits<std::streamsize>::max( ), '\n' );
-	input_stream.getline( inputBuffer_OUT.data( ), static_cast< std::streamsize >(
-						  inputBuffer_OUT.size( ) ) );
+}
+
+template < class T >
+BoundedQueue<T>::BoundedQueue( const std::size_t capacity )
 
-	return std::char_traits<char>::length( inputBuffer_OUT.data( ) );
+	: m_capacity( std::max<std::size_t>( capacity, 1 ) ), m_isClosed( false )
+{
+}
+
+template < class T >
+[[ nodiscard ]] bool BoundedQueue<T>::push( T&& item )
+{
+	{
+		std::unique_lock lock { m_mutex };
+		m_notFull.wait( lock, [ this ] { return m_items.size( ) < m_capacity || m_isClosed; } );
+
+		if ( m_isClosed ) { return false; }
+
+		m_items.push_back( std::move( item ) );
+	}
+
+	m_notEmpty.notify_one( );
+
+	return true;
+}
+
+template < class T >
+[[ nodiscard ]] std::optional<T> BoundedQueue<T>::pop( )
+{
+	std::optional<T> item { };
+
+	{
+		std::unique_lock lock { m_mutex };
+		m_notEmpty.wait( lock, [ this ] { return !m_items.empty( ) || m_isClosed; } );
+
+		if ( m_items.empty( ) ) { return std::nullopt; }
+
+		item.emplace( std::move( m_items.front( ) ) );
+		m_items.pop_front( );
+	}
+
+	m_notFull.notify_one( );
+
+	return item;
+}
+
+template < class T >
+void BoundedQueue<T>::close( ) noexcept
+{
+	{
+		const std::scoped_lock lock { m_mutex };
+		m_isClosed = true;
+	}
+
+	m_notEmpty.notify_all( );
+	m_notFull.notify_all( );
+}
+
+template < class Task >
+void WorkerPool::run( const std::size_t workersCount, const Task& task )
+{
+	run( workersCount, [ ]( const void* const erased_task, const std::size_t workerIdx )
+	{
+		( *static_cast<const Task*>( erased_task ) )( workerIdx );
+	}, &task );
 }
 
 #if __cpp_lib_chrono >= 201907L
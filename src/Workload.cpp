@@ -0,0 +1,448 @@
+
+// PeykNowruzi - Basic ASCII-Art Generator
+// Copyright (C) 2021-2022 Kasra Hashemi
+
+/*
+
+ This file is part of PeykNowruzi.
+
+ PeykNowruzi is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License,
+ or (at your option) any later version.
+
+ PeykNowruzi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty
+ of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with PeykNowruzi. If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "Workload.hpp"
+#include "CharMatrix.hpp"
+#include "Util.hpp"
+#include "pch.hpp"
+
+
+namespace peyknowruzi::workload
+{
+
+namespace
+{
+
+// SplitMix64, chosen over the standard engines and distributions because its
+// output is the same with every standard library
+class RandomSource
+{
+public:
+	explicit RandomSource( const std::uint64_t seed ) noexcept : m_state( seed ) { }
+
+	[[ nodiscard ]] std::uint64_t next( ) noexcept
+	{
+		std::uint64_t z { m_state += 0x9E3779B97F4A7C15 };
+		z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9;
+		z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EB;
+		return z ^ ( z >> 31 );
+	}
+
+	// uniform in [ 0, bound ), bound has to be greater than 0
+	[[ nodiscard ]] std::uint32_t below( const std::uint32_t bound ) noexcept
+	{
+		return static_cast<std::uint32_t>( ( ( next( ) >> 32 ) * bound ) >> 32 );
+	}
+
+	// uniform in [ 0, 1 )
+	[[ nodiscard ]] double unit( ) noexcept
+	{
+		return static_cast<double>( next( ) >> 11 ) * 0x1.0p-53;
+	}
+
+private:
+	std::uint64_t m_state;
+};
+
+using coords_type = std::array<std::uint32_t, 4>;
+
+constexpr std::array spatial_distribution_names
+{
+	std::pair { Spatial_Distribution::uniform, std::string_view { "uniform" } },
+	std::pair { Spatial_Distribution::clustered, std::string_view { "clustered" } },
+	std::pair { Spatial_Distribution::banded, std::string_view { "banded" } },
+};
+
+[[ nodiscard ]] std::uint32_t clamp_to_axis( const std::int64_t value, const std::uint32_t maxValue ) noexcept
+{
+	return static_cast<std::uint32_t>( std::clamp<std::int64_t>( value, 0, maxValue ) );
+}
+
+// the first cell of a character, spread over the canvas as the distribution asks
+class CellPicker
+{
+public:
+	CellPicker( const WorkloadSettings& settings, RandomSource& random_source )
+
+		: m_distribution( settings.distribution ), m_maxX( settings.X_AxisLen - 2 ),
+		  m_maxY( settings.Y_AxisLen - 1 ), m_clusterCenters( ), m_bandTop( ), m_bandHeight( )
+	{
+		for ( coords_type& center : m_clusterCenters )
+		{
+			center = { random_source.below( m_maxX + 1 ), random_source.below( m_maxY + 1 ), 0, 0 };
+		}
+
+		m_bandHeight = std::min( m_maxY + 1, std::max<std::uint32_t>( 2, ( m_maxY + 1 ) / 8 ) );
+		m_bandTop = random_source.below( m_maxY + 2 - m_bandHeight );
+	}
+
+	[[ nodiscard ]] std::pair<std::uint32_t, std::uint32_t> pick( RandomSource& random_source ) const noexcept
+	{
+		switch ( m_distribution )
+		{
+			case Spatial_Distribution::clustered:
+			{
+				// the sum of four uniform offsets piles up around the center
+				const coords_type& center { m_clusterCenters[ random_source.below( clusters_count ) ] };
+				const std::int64_t spreadX { std::max<std::int64_t>( 1, ( m_maxX + 1 ) / 16 ) };
+				const std::int64_t spreadY { std::max<std::int64_t>( 1, ( m_maxY + 1 ) / 16 ) };
+
+				std::int64_t x { center[ 0 ] };
+				std::int64_t y { center[ 1 ] };
+
+				for ( int term { }; term < 4; ++term )
+				{
+					x += static_cast<std::int64_t>( random_source.below( static_cast<std::uint32_t>( 2 * spreadX + 1 ) ) ) -
+						 spreadX;
+					y += static_cast<std::int64_t>( random_source.below( static_cast<std::uint32_t>( 2 * spreadY + 1 ) ) ) -
+						 spreadY;
+				}
+
+				return { clamp_to_axis( x, m_maxX ), clamp_to_axis( y, m_maxY ) };
+			}
+			case Spatial_Distribution::banded:
+				return { random_source.below( m_maxX + 1 ), m_bandTop + random_source.below( m_bandHeight ) };
+			case Spatial_Distribution::uniform:
+			default:
+				return { random_source.below( m_maxX + 1 ), random_source.below( m_maxY + 1 ) };
+		}
+	}
+
+private:
+	static constexpr std::uint32_t clusters_count { 3 };
+
+	Spatial_Distribution m_distribution;
+	std::uint32_t m_maxX;
+	std::uint32_t m_maxY;
+	std::array<coords_type, clusters_count> m_clusterCenters;
+	std::uint32_t m_bandTop;
+	std::uint32_t m_bandHeight;
+};
+
+[[ nodiscard ]] coords_type make_valid_coords( const CellPicker& cell_picker, const std::uint32_t maxX,
+											   const std::uint32_t maxY, RandomSource& random_source ) noexcept
+{
+	const auto [ x1, y1 ] { cell_picker.pick( random_source ) };
+
+	// a step towards one of the eight neighbours, turned back where it would
+	// leave the canvas; a canvas one cell wide or tall only has steps along it
+	std::int64_t dx { maxX == 0 ? 0 : static_cast<std::int64_t>( random_source.below( 3 ) ) - 1 };
+	std::int64_t dy { maxY == 0 ? 0 : static_cast<std::int64_t>( random_source.below( 3 ) ) - 1 };
+
+	if ( dx == 0 && dy == 0 )
+	{
+		if ( maxX != 0 ) { dx = 1; }
+		else { dy = 1; }
+	}
+
+	if ( x1 + dx < 0 || x1 + dx > maxX ) { dx = -dx; }
+	if ( y1 + dy < 0 || y1 + dy > maxY ) { dy = -dy; }
+
+	return { x1, y1, static_cast<std::uint32_t>( x1 + dx ), static_cast<std::uint32_t>( y1 + dy ) };
+}
+
+void append_coords_line( const coords_type& coords, RandomSource& random_source, std::string& input_OUT )
+{
+	// mostly single spaces, now and then the tabs and runs of blanks the input
+	// format also allows
+	static constexpr std::array<std::string_view, 8> separators { " ", " ", " ", " ", " ", "  ", "\t", " \t " };
+
+	for ( std::size_t idx { }; idx < coords.size( ); ++idx )
+	{
+		if ( idx != 0 ) { input_OUT += separators[ random_source.below( separators.size( ) ) ]; }
+
+		input_OUT += std::to_string( coords[ idx ] );
+	}
+
+	input_OUT += '\n';
+}
+
+// a line validateEnteredCoords rejects, so that it is read over without counting
+void append_invalid_line( const WorkloadSettings& settings, RandomSource& random_source, std::string& input_OUT )
+{
+	const std::string x { std::to_string( random_source.below( settings.X_AxisLen - 1 ) ) };
+	const std::string y { std::to_string( random_source.below( settings.Y_AxisLen ) ) };
+
+	switch ( random_source.below( 5 ) )
+	{
+		case 0: // past the right edge
+			input_OUT += std::to_string( settings.X_AxisLen - 1 + random_source.below( 1000 ) ) + ' ' + y + ' ' +
+						 x + ' ' + y;
+			break;
+		case 1: // too few numbers
+			input_OUT += x + ' ' + y + ' ' + x;
+			break;
+		case 2: // too many numbers
+			input_OUT += x + ' ' + y + ' ' + x + ' ' + y + ' ' + x;
+			break;
+		case 3: // not a number
+			input_OUT += x + ' ' + y + " x" + y + ' ' + x;
+			break;
+		default: // negative
+			input_OUT += '-' + x + ' ' + y + ' ' + x + ' ' + y;
+			break;
+	}
+
+	input_OUT += '\n';
+}
+
+}
+
+[[ nodiscard ]] bool parse_workload_option( const std::string_view arg, WorkloadSettings& settings_OUT )
+{
+	using std::string_view_literals::operator""sv;
+
+	static constexpr std::string_view seed_option_prefix { "--seed="sv };
+	static constexpr std::string_view documents_option_prefix { "--documents="sv };
+	static constexpr std::string_view height_option_prefix { "--height="sv };
+	static constexpr std::string_view width_option_prefix { "--width="sv };
+	static constexpr std::string_view fill_option_prefix { "--fill="sv };
+	static constexpr std::string_view density_option_prefix { "--density="sv };
+	static constexpr std::string_view invalid_ratio_option_prefix { "--invalid-ratio="sv };
+	static constexpr std::string_view repeat_ratio_option_prefix { "--repeat-ratio="sv };
+	static constexpr std::string_view distribution_option_prefix { "--distribution="sv };
+
+	if ( arg.starts_with( seed_option_prefix ) )
+	{
+		settings_OUT.seed = util::parse_option_value<std::uint64_t>( arg, seed_option_prefix );
+	}
+	else if ( arg.starts_with( documents_option_prefix ) )
+	{
+		settings_OUT.documentsCount = util::parse_option_value<std::size_t>( arg, documents_option_prefix );
+	}
+	else if ( arg.starts_with( height_option_prefix ) )
+	{
+		settings_OUT.Y_AxisLen = util::parse_option_value<std::uint32_t>( arg, height_option_prefix );
+	}
+	else if ( arg.starts_with( width_option_prefix ) )
+	{
+		settings_OUT.X_AxisLen = util::parse_option_value<std::uint32_t>( arg, width_option_prefix );
+	}
+	else if ( arg.starts_with( fill_option_prefix ) )
+	{
+		if ( arg.size( ) != fill_option_prefix.size( ) + 1 )
+		{
+			throw std::runtime_error( "Invalid_Option_Exception: '" + std::string { arg } +
+									  "' expects a single character" );
+		}
+
+		settings_OUT.fillCharacter = arg.back( );
+	}
+	else if ( arg.starts_with( density_option_prefix ) )
+	{
+		settings_OUT.density = util::parse_option_value<double>( arg, density_option_prefix );
+	}
+	else if ( arg.starts_with( invalid_ratio_option_prefix ) )
+	{
+		settings_OUT.invalidLineRatio = util::parse_option_value<double>( arg, invalid_ratio_option_prefix );
+	}
+	else if ( arg.starts_with( repeat_ratio_option_prefix ) )
+	{
+		settings_OUT.repeatRatio = util::parse_option_value<double>( arg, repeat_ratio_option_prefix );
+	}
+	else if ( arg.starts_with( distribution_option_prefix ) )
+	{
+		const std::string_view distributionName { arg.substr( distribution_option_prefix.size( ) ) };
+		const auto found { std::ranges::find( spatial_distribution_names, distributionName,
+											  &decltype( spatial_distribution_names )::value_type::second ) };
+
+		if ( found == spatial_distribution_names.end( ) )
+		{
+			throw std::runtime_error( "Invalid_Option_Exception: '" + std::string { arg } +
+									  "' expects one of uniform, clustered or banded" );
+		}
+
+		settings_OUT.distribution = found->first;
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+void validate_workload_settings( const WorkloadSettings& settings )
+{
+	// --batch draws a canvas beyond the dense limits on a tiled one, so only the
+	// tiled limits apply; a canvas needs room for at least one character of two cells
+	if ( settings.Y_AxisLen > TiledCharMatrix<>::max_allowed_y_axis_len ||
+		 settings.X_AxisLen > TiledCharMatrix<>::max_allowed_x_axis_len ||
+		 settings.X_AxisLen < TiledCharMatrix<>::min_allowed_x_axis_len ||
+		 std::uint64_t { settings.Y_AxisLen } * ( settings.X_AxisLen - 1 ) < 2 )
+	{
+		throw std::runtime_error( "Invalid_Option_Exception: The canvas has to have room for two cells" );
+	}
+
+	if ( std::string_view { " \t\n\r-\\/|" }.find( settings.fillCharacter ) != std::string_view::npos )
+	{
+		throw std::runtime_error( "Invalid_Option_Exception: The fill character can not be blank or "
+								  "one of the characters lines are drawn with" );
+	}
+
+	if ( !( settings.density > 0.0 && settings.density <= 1.0 ) )
+	{
+		throw std::runtime_error( "Invalid_Option_Exception: The density has to be greater than 0 and at most 1" );
+	}
+
+	if ( !( settings.invalidLineRatio >= 0.0 && settings.invalidLineRatio <= 1000.0 ) )
+	{
+		throw std::runtime_error( "Invalid_Option_Exception: The invalid line ratio has to be between 0 and 1000" );
+	}
+
+	if ( !( settings.repeatRatio >= 0.0 && settings.repeatRatio <= 1.0 ) )
+	{
+		throw std::runtime_error( "Invalid_Option_Exception: The repeat ratio has to be between 0 and 1" );
+	}
+}
+
+WorkloadStats generate_workload( const WorkloadSettings& settings, std::string& input_OUT,
+								 std::string* const expectedOutput_OUT )
+{
+	validate_workload_settings( settings );
+
+	const std::uint32_t maxX { settings.X_AxisLen - 2 };
+	const std::uint32_t maxY { settings.Y_AxisLen - 1 };
+	const std::size_t maxLinesCount { std::size_t { settings.Y_AxisLen } * ( settings.X_AxisLen - 1 ) / 2 };
+	const std::size_t linesPerDocument { std::clamp<std::size_t>(
+		static_cast<std::size_t>( std::llround( settings.density * static_cast<double>( maxLinesCount ) ) ),
+		1, maxLinesCount ) };
+
+	// an invalid line comes before each valid one with this probability, again
+	// after each invalid one, which makes invalidLineRatio of them per valid line
+	const double invalidLineProbability { settings.invalidLineRatio / ( 1.0 + settings.invalidLineRatio ) };
+
+	RandomSource random_source { settings.seed };
+	WorkloadStats stats { settings.documentsCount, 0, 0 };
+
+	const std::string attributesLine { std::to_string( settings.Y_AxisLen ) + ' ' +
+									   std::to_string( settings.X_AxisLen ) + ' ' + settings.fillCharacter + '\n' +
+									   std::to_string( linesPerDocument ) + '\n' };
+
+	// where the last document generated starts and how long it is, in the input
+	// and in the expected output
+	std::size_t prevDocumentInputOffset { };
+	std::size_t prevDocumentInputLen { };
+	std::size_t prevDocumentOutputOffset { };
+	std::size_t prevDocumentOutputLen { };
+	std::size_t prevDocumentLinesCount { };
+	std::size_t prevDocumentInvalidLinesCount { };
+
+	for ( std::size_t document { }; document < settings.documentsCount; ++document )
+	{
+		if ( document != 0 && settings.repeatRatio > 0.0 && random_source.unit( ) < settings.repeatRatio )
+		{
+			input_OUT.append( input_OUT, prevDocumentInputOffset, prevDocumentInputLen );
+			stats.linesCount += prevDocumentLinesCount;
+			stats.invalidLinesCount += prevDocumentInvalidLinesCount;
+
+			if ( expectedOutput_OUT != nullptr )
+			{
+				expectedOutput_OUT->append( *expectedOutput_OUT, prevDocumentOutputOffset, prevDocumentOutputLen );
+			}
+
+			continue;
+		}
+
+		prevDocumentInputOffset = input_OUT.size( );
+		prevDocumentOutputOffset = expectedOutput_OUT != nullptr ? expectedOutput_OUT->size( ) : 0;
+		prevDocumentLinesCount = stats.linesCount;
+		prevDocumentInvalidLinesCount = stats.invalidLinesCount;
+
+		const CellPicker cell_picker { settings, random_source };
+		std::optional< ReferenceRenderer > reference_renderer { };
+
+		if ( expectedOutput_OUT != nullptr )
+		{
+			reference_renderer.emplace( settings.Y_AxisLen, settings.X_AxisLen, settings.fillCharacter );
+		}
+
+		input_OUT += attributesLine;
+		stats.linesCount += 2;
+
+		for ( std::size_t line { }; line < linesPerDocument; ++line )
+		{
+			// invalid lines only ever come before a valid one, after the last one of a
+			// document they would be taken for the attributes of the next
+			while ( invalidLineProbability > 0.0 && random_source.unit( ) < invalidLineProbability )
+			{
+				append_invalid_line( settings, random_source, input_OUT );
+				++stats.invalidLinesCount;
+				++stats.linesCount;
+			}
+
+			const coords_type coords { make_valid_coords( cell_picker, maxX, maxY, random_source ) };
+
+			append_coords_line( coords, random_source, input_OUT );
+			++stats.linesCount;
+
+			if ( reference_renderer ) { reference_renderer->draw( coords ); }
+		}
+
+		if ( reference_renderer ) { reference_renderer->render( *expectedOutput_OUT ); }
+
+		prevDocumentInputLen = input_OUT.size( ) - prevDocumentInputOffset;
+		prevDocumentOutputLen = expectedOutput_OUT != nullptr ? expectedOutput_OUT->size( ) - prevDocumentOutputOffset : 0;
+		prevDocumentLinesCount = stats.linesCount - prevDocumentLinesCount;
+		prevDocumentInvalidLinesCount = stats.invalidLinesCount - prevDocumentInvalidLinesCount;
+	}
+
+	return stats;
+}
+
+ReferenceRenderer::ReferenceRenderer( const std::uint32_t Y_AxisLen, const std::uint32_t X_AxisLen,
+									  const char fillCharacter )
+
+	: m_rows( Y_AxisLen, std::string( X_AxisLen - 1, fillCharacter ) )
+{
+}
+
+void ReferenceRenderer::draw( const std::array<std::uint32_t, 4>& coordsOfChar )
+{
+	const auto [ x1, y1, x2, y2 ] { coordsOfChar };
+	const std::int64_t dx { std::int64_t { x2 } - x1 };
+	const std::int64_t dy { std::int64_t { y2 } - y1 };
+
+	char ch { };
+
+	if ( dy == 0 && ( dx == 1 || dx == -1 ) ) { ch = '-'; }
+	else if ( dx == 0 && ( dy == 1 || dy == -1 ) ) { ch = '|'; }
+	else if ( ( dx == 1 && dy == 1 ) || ( dx == -1 && dy == -1 ) ) { ch = '\\'; }
+	else if ( ( dx == 1 && dy == -1 ) || ( dx == -1 && dy == 1 ) ) { ch = '/'; }
+	else { return; }
+
+	m_rows.at( y1 ).at( x1 ) = ch;
+	m_rows.at( y2 ).at( x2 ) = ch;
+}
+
+void ReferenceRenderer::render( std::string& output_OUT ) const
+{
+	for ( const std::string& row : m_rows )
+	{
+		output_OUT += row;
+		output_OUT += '\n';
+	}
+}
+
+}
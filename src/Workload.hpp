@@ -0,0 +1,88 @@
+
+// PeykNowruzi - Basic ASCII-Art Generator
+// Copyright (C) 2021-2022 Kasra Hashemi
+
+/*
+
+ This file is part of PeykNowruzi.
+
+ PeykNowruzi is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License,
+ or (at your option) any later version.
+
+ PeykNowruzi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty
+ of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with PeykNowruzi. If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+
+#pragma once
+
+#include "pch.hpp"
+
+
+namespace peyknowruzi::workload
+{
+
+enum class Spatial_Distribution
+{
+	uniform, // characters anywhere on the canvas
+	clustered, // characters around a few points of each canvas
+	banded, // characters in one band of rows of each canvas, which unbalances the row bands
+};
+
+// what the generator is asked to produce; the same settings and seed always
+// produce the same stream
+struct WorkloadSettings
+{
+	std::uint64_t seed { 1 };
+	std::size_t documentsCount { 1000 };
+	std::uint32_t Y_AxisLen { 36 };
+	std::uint32_t X_AxisLen { 168 };
+	char fillCharacter { '.' };
+	double density { 0.1 }; // share of the most coordinate lines a canvas accepts
+	double invalidLineRatio { }; // invalid coordinate lines per valid one, on average
+	double repeatRatio { }; // share of documents that are a copy of the one before, for the render cache
+	Spatial_Distribution distribution { Spatial_Distribution::uniform };
+};
+
+struct WorkloadStats
+{
+	std::size_t documentsCount;
+	std::size_t linesCount; // every line of the stream
+	std::size_t invalidLinesCount;
+};
+
+// consumes arg if it is one of the generator options, throws on a bad value
+[[ nodiscard ]] bool parse_workload_option( const std::string_view arg, WorkloadSettings& settings_OUT );
+
+// checks the settings as a whole once all the options have been parsed
+void validate_workload_settings( const WorkloadSettings& settings );
+
+// appends a stream of documents in the format of --batch to input_OUT and, when
+// expectedOutput_OUT is given, what drawing them has to print
+WorkloadStats generate_workload( const WorkloadSettings& settings, std::string& input_OUT,
+								 std::string* const expectedOutput_OUT );
+
+// A renderer that shares no code with CharMatrix and only follows the rules of
+// the input: each coordinate line draws the character its direction calls for
+// on both of its cells, later lines draw over earlier ones.
+class ReferenceRenderer
+{
+public:
+	ReferenceRenderer( const std::uint32_t Y_AxisLen, const std::uint32_t X_AxisLen, const char fillCharacter );
+
+	void draw( const std::array<std::uint32_t, 4>& coordsOfChar );
+	void render( std::string& output_OUT ) const;
+
+private:
+	std::vector< std::string > m_rows;
+};
+
+}
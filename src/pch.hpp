@@ -29,6 +29,7 @@
 #include <ios>
 #include <sstream>
 #include <fstream>
+#include <filesystem>
 
 #include <string>
 #include <string_view>
@@ -39,19 +40,35 @@
 #include <iterator>
 #include <ranges>
 #include <unordered_set>
+#include <unordered_map>
+#include <list>
 #include <utility>
 #include <functional>
 #include <optional>
+#include <variant>
 #include <concepts>
 
 #include <algorithm>
+#include <numeric>
+#include <bit>
 
 #include <memory>
 #include <memory_resource>
 #include <stdexcept>
 
 #include <cstddef>
+#include <cerrno>
 #include <cstdlib>
+#include <cstring>
+#include <cmath>
 
 #include <limits>
 #include <chrono>
+#include <thread>
+#include <barrier>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <streambuf>
+#include <exception>